@@ -0,0 +1,186 @@
+// Corpus.cpp
+#include "Corpus.h"
+
+namespace {
+
+// splitmix64: tiny, and unlike std::uniform_int_distribution its output is
+// the same with every standard library
+struct Rng {
+    std::uint64_t s;
+    std::uint64_t next() {
+        std::uint64_t z = (s += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+    size_t below(size_t n) { return static_cast<size_t>(next() % n); }
+};
+
+const char* const kVars[]    = { "a", "b", "i", "s", "acc" };
+const char* const kTargets[] = { "i", "s", "acc" };
+const char* const kOps[]     = { "+", "-", "*", "/" };
+const char* const kRelops[]  = { "<", ">", "<=", ">=", "==", "!=" };
+const char* const kWords[]   = { "loop", "sum", "of", "terms", "step", "value", "the", "next", "pass", "check" };
+
+template <size_t N>
+const char* pick(Rng& r, const char* const (&list)[N]) { return list[r.below(N)]; }
+
+class Generator {
+public:
+    explicit Generator(const CorpusShape& shape) : shape_(shape), rng_{shape.seed} {}
+
+    std::string run() {
+        for (size_t f = 0; f < shape_.functions; ++f) function(f);
+        out_ += "integer x , y ;\nx = 1 ;\nput ( x ) ;\n";
+        return std::move(out_);
+    }
+
+private:
+    void indent(size_t level) { out_.append(level * 4, ' '); }
+
+    void banner(size_t f) {
+        out_ += '"';
+        size_t start = out_.size();
+        out_ += "---- f" + std::to_string(f) + " ----";
+        size_t lineStart = start;
+        while (out_.size() - start < shape_.bannerBytes) {
+            // long banners wrap like a comment block
+            if (out_.size() - lineStart >= 72) { out_ += '\n'; lineStart = out_.size(); }
+            else out_ += ' ';
+            out_ += pick(rng_, kWords);
+        }
+        out_ += "\"\n";
+    }
+
+    void function(size_t f) {
+        fn_ = f;
+        if (shape_.bannerBytes) banner(f);
+        out_ += "function f" + std::to_string(f) + " ( a integer , b real )\ninteger i , s ;\nreal acc ;\n{\n";
+        block(shape_.depth, 1);
+        indent(1);
+        out_ += "return ";
+        expr();
+        out_ += " ;\n}\n";
+    }
+
+    // `statements` statements; one of them opens the next nesting level
+    void block(size_t depth, size_t level) {
+        size_t nestAt = shape_.statements / 2;
+        for (size_t k = 0; k < shape_.statements; ++k) {
+            if (depth > 0 && k == nestAt) nested(depth, level);
+            else simple(level);
+        }
+        if (shape_.statements == 0 && depth > 0) nested(depth, level);
+    }
+
+    void nested(size_t depth, size_t level) {
+        indent(level);
+        if (depth % 2 == 0) {
+            out_ += "while ( ";
+            condition();
+            out_ += " ) {\n";
+            block(depth - 1, level + 1);
+            indent(level);
+            out_ += "}\n";
+        } else {
+            out_ += "if ( ";
+            condition();
+            out_ += " ) {\n";
+            block(depth - 1, level + 1);
+            indent(level);
+            out_ += "} else s = s + 1 ; fi\n";
+        }
+    }
+
+    void simple(size_t level) {
+        indent(level);
+        switch (rng_.below(8)) {
+            case 0:  out_ += "put ( s ) ;\n"; return;
+            case 1:  out_ += "get ( a , b ) ;\n"; return;
+            default: break;
+        }
+        out_ += pick(rng_, kTargets);
+        out_ += " = ";
+        expr();
+        out_ += " ;\n";
+    }
+
+    void condition() {
+        expr();
+        out_ += ' ';
+        out_ += pick(rng_, kRelops);
+        out_ += ' ';
+        expr();
+    }
+
+    void expr() {
+        size_t terms = shape_.exprTerms ? shape_.exprTerms : 1;
+        for (size_t t = 0; t < terms; ++t) {
+            if (t) {
+                out_ += ' ';
+                out_ += pick(rng_, kOps);
+                out_ += ' ';
+            }
+            operand();
+        }
+    }
+
+    void operand() {
+        switch (rng_.below(10)) {
+            case 0:
+                out_ += std::to_string(rng_.below(1000));
+                return;
+            case 1:
+                out_ += std::to_string(rng_.below(100)) + "." + std::to_string(10 + rng_.below(90));
+                return;
+            case 2:
+                out_ += "( ";
+                out_ += pick(rng_, kVars);
+                out_ += " + ";
+                out_ += pick(rng_, kVars);
+                out_ += " )";
+                return;
+            case 3:
+                out_ += "f" + std::to_string(rng_.below(fn_ + 1)) + " ( a , b )";
+                return;
+            case 4:
+                out_ += "- ";
+                out_ += pick(rng_, kVars);
+                return;
+            default:
+                out_ += pick(rng_, kVars);
+                return;
+        }
+    }
+
+    const CorpusShape& shape_;
+    Rng rng_;
+    std::string out_;
+    size_t fn_ = 0;
+};
+
+} // namespace
+
+std::vector<CorpusShape> defaultCorpusShapes() {
+    std::vector<CorpusShape> shapes(4);
+    shapes[0].name = "functions";
+    shapes[0].functions = 20000;
+
+    shapes[1].name = "nesting";
+    shapes[1].functions = 500;
+    shapes[1].statements = 3;
+    shapes[1].depth = 64;
+
+    shapes[2].name = "expressions";
+    shapes[2].functions = 2000;
+    shapes[2].exprTerms = 64;
+
+    shapes[3].name = "strings";
+    shapes[3].functions = 5000;
+    shapes[3].bannerBytes = 4096;
+    return shapes;
+}
+
+std::string makeCorpus(const CorpusShape& shape) {
+    return Generator(shape).run();
+}
@@ -0,0 +1,25 @@
+// Corpus.h
+// Seeded generator for synthetic Rat25F programs used by the benchmarks.
+// The same shape and seed always produce the same bytes, on any platform
+// (own PRNG, no <random> distributions), so results can be compared over time.
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct CorpusShape {
+    std::string name = "default";
+    size_t functions = 2000;     // top-level function definitions
+    size_t statements = 6;       // statements per block (function body, while body)
+    size_t depth = 2;            // while/if nesting inside each body
+    size_t exprTerms = 4;        // operands per arithmetic expression
+    size_t bannerBytes = 24;     // string banner before each function (0 = none)
+    std::uint64_t seed = 1;
+};
+
+// The presets the suite runs when no shape is given on the command line:
+// many small functions, deep while/if nesting, long expressions, long banners.
+std::vector<CorpusShape> defaultCorpusShapes();
+
+std::string makeCorpus(const CorpusShape& shape);
@@ -0,0 +1,115 @@
+// parser_bench.cpp
+// Runtime-flag silence (Parser<FullTrace>, master/echo off) vs the
+// compile-time silent Parser<NoTrace> on the same synthetic program, plus
+// the cost of building the AST and of semantic checks on top of a silent
+// parse, an incremental reparse after a one-function edit, and a silent
+// parse fed from a token cache file instead of the Lexer.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include "Incremental.h"
+#include "Lexer.h"
+#include "TokenCache.h"
+#include "parser.h"
+
+static std::string makeProgram(size_t functions) {
+    std::string src;
+    for (size_t f = 0; f < functions; ++f) {
+        std::string n = std::to_string(f);
+        src += "\"---- function " + n + " ----\"\n";
+        src += "function f" + n + " ( a integer , b real )\ninteger i , s ;\nreal acc ;\n{\n";
+        src += "    s = 0 ;\n    i = 1 ;\n";
+        src += "    while ( i <= a ) {\n        s = s + i * 2 - ( a / 3 ) ;\n";
+        src += "        if ( s > 100 ) s = s - 100 ; else s = s + 1 ; fi\n";
+        src += "        acc = acc * b + 1.25 ;\n        i = i + 1 ;\n    }\n";
+        src += "    put ( s ) ;\n    get ( a , b ) ;\n    return s + f" + n + " ( a , b ) ;\n}\n";
+    }
+    src += "integer x , y ;\nx = 1 ;\nput ( x ) ;\n";
+    return src;
+}
+
+template <class P>
+static double timeParse(const std::string& src, const TraceConfig& trace,
+                        const ParserPolicy& policy, int reps, ParseResult* ast = nullptr) {
+    double best = 1e30;
+    for (int r = 0; r < reps; ++r) {
+        auto t0 = std::chrono::steady_clock::now();
+        Lexer lex(src);
+        P parser(lex, trace, policy);
+        if (ast) parser.parse(StartSymbol::Program, *ast);
+        else     parser.parse(StartSymbol::Program);
+        auto t1 = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double>(t1 - t0).count());
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    size_t functions = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+    int reps = argc > 2 ? std::atoi(argv[2]) : 5;
+    std::string src = makeProgram(functions);
+    double mb = static_cast<double>(src.size()) / (1024.0 * 1024.0);
+
+    TraceConfig off;
+    off.master = false;
+    ParserPolicy quiet;
+    quiet.echoTokens = false;
+
+    double runtime = timeParse<Parser<FullTrace>>(src, off, quiet, reps);
+    double silent  = timeParse<Parser<NoTrace>>(src, off, quiet, reps);
+    ParserPolicy checked = quiet;
+    checked.semanticChecks = true;
+    double withChecks = timeParse<Parser<NoTrace>>(src, off, checked, reps);
+    ParseResult ast;
+    double withAst = timeParse<Parser<NoTrace>>(src, off, quiet, reps, &ast);
+
+    // incremental: cold update, then the same file with one function edited
+    IncrementalParser inc(off, quiet);
+    double cold = 0, warm = 1e30;
+    {
+        NullSink null;
+        auto t0 = std::chrono::steady_clock::now();
+        inc.update(src, null);
+        cold = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        std::string edited = src;
+        size_t at = edited.find("s = 0 ;", edited.size() / 2);
+        for (int r = 0; r < reps; ++r) {
+            edited[at + 4] = static_cast<char>('1' + r % 9);   // differs from the cached text
+            auto t1 = std::chrono::steady_clock::now();
+            inc.update(edited, null);
+            warm = std::min(warm, std::chrono::duration<double>(std::chrono::steady_clock::now() - t1).count());
+        }
+    }
+
+    // token cache: write once, then parse from the mapped file
+    double cachedParse = 0;
+    const char* cachePath = "parser_bench.tok";
+    if (writeTokenCache(cachePath, src)) {
+        cachedParse = 1e30;
+        for (int r = 0; r < reps; ++r) {
+            auto t0 = std::chrono::steady_clock::now();
+            TokenCacheReader reader;
+            reader.open(cachePath, hashSource(src), src.size());
+            Parser<NoTrace> parser(reader, off, quiet);
+            parser.parse(StartSymbol::Program);
+            cachedParse = std::min(cachedParse, std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+        }
+        std::remove(cachePath);
+    }
+
+    std::printf("input: %.2f MB (%zu functions), best of %d\n", mb, functions, reps);
+    std::printf("Parser<FullTrace> flags off : %8.2f ms  %8.1f MB/s\n", runtime * 1e3, mb / runtime);
+    std::printf("Parser<NoTrace>             : %8.2f ms  %8.1f MB/s\n", silent * 1e3, mb / silent);
+    std::printf("speedup                     : %8.2fx\n", runtime / silent);
+    std::printf("Parser<NoTrace> + checks    : %8.2f ms  %8.1f MB/s\n", withChecks * 1e3, mb / withChecks);
+    std::printf("Parser<NoTrace> + AST       : %8.2f ms  %8.1f MB/s  (%zu nodes, %zu KB)\n",
+                withAst * 1e3, mb / withAst, ast.nodeCount(),
+                ast.nodes.capacity() * sizeof(AstNode) / 1024);
+    std::printf("incremental cold / 1 edit   : %8.2f ms  %8.2f ms  (%zu of %zu spans reparsed)\n",
+                cold * 1e3, warm * 1e3, inc.stats().reparsed, inc.stats().spans);
+    if (cachedParse > 0)
+        std::printf("Parser<NoTrace> from .tok   : %8.2f ms  %8.1f MB/s  (incl. hash + validate)\n",
+                    cachedParse * 1e3, mb / cachedParse);
+    return 0;
+}
@@ -0,0 +1,313 @@
+// suite_bench.cpp
+// Throughput suite over seeded synthetic corpora (Corpus.h). Per shape:
+//   lex              Lexer::nextToken() alone
+//   parse_notrace    silent Parser<NoTrace> parse
+//   parse_fulltrace  Parser<FullTrace>, every production and token to /dev/null
+//   parse_bintrace   the same into a BinaryTraceSink
+//   parse_pipelined  silent parse fed by a PipelinedLexer (second thread)
+//   ll1_notrace      silent parse, table-driven LL1Parser
+//   ll1_fulltrace    full-trace parse, table-driven LL1Parser
+//   tokbuf_build     building a TokenBuffer
+//   parse_tokbuf     silent parse walking that TokenBuffer
+// Reports MB/s, tokens/s, peak RSS and heap allocations per workload;
+// --json writes the same numbers for keeping a history.
+//
+//   suite_bench [--reps N] [--seed S] [--scale F] [--json FILE|-]
+//               [--functions N] [--statements N] [--depth N] [--terms N] [--banner N]
+//
+// Any of the shape flags runs one "custom" shape instead of the presets.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <exception>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include "Corpus.h"
+#include "LL1Parser.h"
+#include "BinaryTrace.h"
+#include "Lexer.h"
+#include "PipelinedLexer.h"
+#include "TokenBuffer.h"
+#include "parser.h"
+
+// ----- allocation counting -----
+// Replaces the global operator new/delete for this binary only.
+static std::atomic<size_t> gAllocs{0};
+static std::atomic<size_t> gAllocBytes{0};
+
+// Kept out of line: once inlined, GCC pairs the malloc/free underneath and
+// warns about mismatched new/delete.
+__attribute__((noinline)) void* operator new(size_t n) {
+    gAllocs.fetch_add(1, std::memory_order_relaxed);
+    gAllocBytes.fetch_add(n, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+__attribute__((noinline)) void operator delete(void* p) noexcept { std::free(p); }
+void* operator new[](size_t n) { return ::operator new(n); }
+void operator delete[](void* p) noexcept { ::operator delete(p); }
+void operator delete(void* p, size_t) noexcept { ::operator delete(p); }
+void operator delete[](void* p, size_t) noexcept { ::operator delete(p); }
+
+// ----- peak RSS -----
+// Linux lets a process reset its high-water mark (clear_refs "5"), so each
+// workload gets its own peak; elsewhere it is the process peak so far.
+static bool resetPeakRss() {
+    FILE* f = std::fopen("/proc/self/clear_refs", "w");
+    if (!f) return false;
+    bool ok = std::fputs("5", f) >= 0;
+    return std::fclose(f) == 0 && ok;
+}
+
+static size_t peakRssKb() {
+    if (FILE* f = std::fopen("/proc/self/status", "r")) {
+        char line[256];
+        size_t kb = 0;
+        while (std::fgets(line, sizeof line, f))
+            if (std::strncmp(line, "VmHWM:", 6) == 0) kb = std::strtoul(line + 6, nullptr, 10);
+        std::fclose(f);
+        if (kb) return kb;
+    }
+    rusage ru{};
+    getrusage(RUSAGE_SELF, &ru);
+    return static_cast<size_t>(ru.ru_maxrss);
+}
+
+// ----- workloads -----
+struct Measure {
+    const char* workload;
+    double seconds = 0;     // best of reps
+    size_t tokens = 0;
+    size_t allocs = 0;      // per run
+    size_t allocBytes = 0;
+    size_t peakKb = 0;
+    bool peakReset = false; // false: peakKb is the process peak so far
+};
+
+template <class Fn>
+static Measure measure(const char* workload, int reps, Fn&& run) {
+    Measure m;
+    m.workload = workload;
+    m.peakReset = resetPeakRss();
+    m.seconds = 1e30;
+    for (int r = 0; r < reps; ++r) {
+        size_t a0 = gAllocs.load(), b0 = gAllocBytes.load();
+        auto t0 = std::chrono::steady_clock::now();
+        m.tokens = run();
+        double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        m.allocs = gAllocs.load() - a0;
+        m.allocBytes = gAllocBytes.load() - b0;
+        if (s < m.seconds) m.seconds = s;
+    }
+    m.peakKb = peakRssKb();
+    return m;
+}
+
+static size_t lexOnly(const std::string& src) {
+    Lexer lex(src);
+    size_t n = 0;
+    while (lex.nextToken().type != TokenType::EndOfFile) ++n;
+    return n;
+}
+
+struct ShapeResult {
+    CorpusShape shape;
+    size_t bytes = 0;
+    bool parsed = true;
+    size_t tokens = 0;
+    size_t tokbufBytes = 0;   // TokenBuffer::bytesUsed() for the corpus
+    std::vector<Measure> runs;
+};
+
+static ShapeResult runShape(const CorpusShape& shape, int reps) {
+    ShapeResult res;
+    res.shape = shape;
+    std::string src = makeCorpus(shape);
+    res.bytes = src.size();
+
+    size_t tokens = lexOnly(src);
+    res.tokens = tokens;
+    res.runs.push_back(measure("lex", reps, [&] { return lexOnly(src); }));
+
+    TraceConfig off;
+    off.master = false;
+    ParserPolicy quiet;
+    quiet.echoTokens = false;
+    auto null = std::make_shared<NullSink>();
+    try {
+        res.runs.push_back(measure("parse_notrace", reps, [&] {
+            Lexer lex(src);
+            Parser<NoTrace> parser(lex, off, quiet, null);
+            parser.parse(StartSymbol::Program);
+            return tokens;
+        }));
+        res.runs.push_back(measure("parse_fulltrace", reps, [&] {
+            Lexer lex(src);
+            Parser<FullTrace> parser(lex, TraceConfig{}, ParserPolicy{},
+                                     std::make_shared<BufferedFileSink>("/dev/null"));
+            parser.parse(StartSymbol::Program);
+            return tokens;
+        }));
+        res.runs.push_back(measure("parse_bintrace", reps, [&] {
+            Lexer lex(src);
+            Parser<FullTrace> parser(lex, TraceConfig{}, ParserPolicy{},
+                                     std::make_shared<BinaryTraceSink>("/dev/null", src));
+            parser.parse(StartSymbol::Program);
+            return tokens;
+        }));
+        res.runs.push_back(measure("parse_pipelined", reps, [&] {
+            PipelinedLexer lex(src);
+            Parser<NoTrace> parser(lex, off, quiet, null);
+            parser.parse(StartSymbol::Program);
+            return tokens;
+        }));
+        // same two runs on the explicit-stack LL(1) backend
+        res.runs.push_back(measure("ll1_notrace", reps, [&] {
+            Lexer lex(src);
+            LL1Parser<NoTrace> parser(lex, off, quiet, null);
+            parser.parse(StartSymbol::Program);
+            return tokens;
+        }));
+        res.runs.push_back(measure("ll1_fulltrace", reps, [&] {
+            Lexer lex(src);
+            LL1Parser<FullTrace> parser(lex, TraceConfig{}, ParserPolicy{},
+                                        std::make_shared<BufferedFileSink>("/dev/null"));
+            parser.parse(StartSymbol::Program);
+            return tokens;
+        }));
+        // whole-file token arrays, then a parse that only indexes them
+        TokenBuffer buf;
+        res.runs.push_back(measure("tokbuf_build", reps, [&] {
+            buf.build(src);
+            return buf.size() - 1;
+        }));
+        res.runs.push_back(measure("parse_tokbuf", reps, [&] {
+            TokenCursor cursor(buf);
+            Parser<NoTrace> parser(cursor, off, quiet, null);
+            parser.parse(StartSymbol::Program);
+            return tokens;
+        }));
+        res.tokbufBytes = buf.bytesUsed();
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s: generated corpus does not parse: %s\n", shape.name.c_str(), e.what());
+        res.parsed = false;
+    }
+    return res;
+}
+
+// ----- report -----
+static void printTable(const std::vector<ShapeResult>& results, int reps) {
+    std::printf("best of %d\n", reps);
+    std::printf("%-12s %-16s %9s %10s %9s %11s %10s %10s\n",
+                "shape", "workload", "MB", "ms", "MB/s", "Mtok/s", "allocs", "peak KB");
+    for (const auto& r : results) {
+        double mb = static_cast<double>(r.bytes) / (1024.0 * 1024.0);
+        for (const auto& m : r.runs)
+            std::printf("%-12s %-16s %9.2f %10.2f %9.1f %11.2f %10zu %10zu\n",
+                        r.shape.name.c_str(), m.workload, mb, m.seconds * 1e3, mb / m.seconds,
+                        static_cast<double>(m.tokens) / m.seconds / 1e6, m.allocs, m.peakKb);
+        if (r.tokens)
+            std::printf("%-12s token buffer %.1f bytes/token (%zu tokens, Token is %zu bytes)\n",
+                        r.shape.name.c_str(), static_cast<double>(r.tokbufBytes) / static_cast<double>(r.tokens),
+                        r.tokens, sizeof(Token));
+    }
+}
+
+static void writeJson(FILE* f, const std::vector<ShapeResult>& results, int reps) {
+    std::fprintf(f, "{\n  \"benchmark\": \"rat25f-suite\",\n  \"version\": 1,\n");
+    std::fprintf(f, "  \"timestamp\": %lld,\n", static_cast<long long>(std::time(nullptr)));
+    std::fprintf(f, "  \"compiler\": \"%s\",\n", __VERSION__);
+#ifdef NDEBUG
+    std::fprintf(f, "  \"ndebug\": true,\n");
+#else
+    std::fprintf(f, "  \"ndebug\": false,\n");
+#endif
+    std::fprintf(f, "  \"reps\": %d,\n  \"shapes\": [\n", reps);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        const auto& s = r.shape;
+        std::fprintf(f, "    {\"name\": \"%s\", \"seed\": %llu, \"functions\": %zu, \"statements\": %zu, "
+                        "\"depth\": %zu, \"expr_terms\": %zu, \"banner_bytes\": %zu,\n",
+                     s.name.c_str(), static_cast<unsigned long long>(s.seed), s.functions,
+                     s.statements, s.depth, s.exprTerms, s.bannerBytes);
+        std::fprintf(f, "     \"bytes\": %zu, \"tokens\": %zu, \"tokbuf_bytes\": %zu, \"parsed\": %s, \"results\": [\n",
+                     r.bytes, r.tokens, r.tokbufBytes, r.parsed ? "true" : "false");
+        for (size_t j = 0; j < r.runs.size(); ++j) {
+            const auto& m = r.runs[j];
+            std::fprintf(f, "       {\"workload\": \"%s\", \"seconds\": %.6f, \"mb_per_s\": %.3f, "
+                            "\"tokens\": %zu, \"tokens_per_s\": %.0f, \"allocs\": %zu, "
+                            "\"alloc_bytes\": %zu, \"peak_rss_kb\": %zu, \"peak_rss_reset\": %s}%s\n",
+                         m.workload, m.seconds,
+                         static_cast<double>(r.bytes) / (1024.0 * 1024.0) / m.seconds,
+                         m.tokens, static_cast<double>(m.tokens) / m.seconds,
+                         m.allocs, m.allocBytes, m.peakKb, m.peakReset ? "true" : "false",
+                         j + 1 < r.runs.size() ? "," : "");
+        }
+        std::fprintf(f, "     ]}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(f, "  ]\n}\n");
+}
+
+int main(int argc, char** argv) {
+    int reps = 5;
+    double scale = 1.0;
+    std::uint64_t seed = 1;
+    const char* jsonPath = nullptr;
+    CorpusShape custom;
+    custom.name = "custom";
+    bool haveCustom = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (i + 1 >= argc) {
+            std::fprintf(stderr, "missing value for %s\n", a.c_str());
+            return 2;
+        }
+        const char* v = argv[++i];
+        auto num = [&] { return static_cast<size_t>(std::strtoull(v, nullptr, 10)); };
+        if      (a == "--reps")       reps = std::max(1, std::atoi(v));
+        else if (a == "--seed")       seed = std::strtoull(v, nullptr, 10);
+        else if (a == "--scale")      scale = std::atof(v);
+        else if (a == "--json")       jsonPath = v;
+        else if (a == "--functions")  { custom.functions = num();   haveCustom = true; }
+        else if (a == "--statements") { custom.statements = num();  haveCustom = true; }
+        else if (a == "--depth")      { custom.depth = num();       haveCustom = true; }
+        else if (a == "--terms")      { custom.exprTerms = num();   haveCustom = true; }
+        else if (a == "--banner")     { custom.bannerBytes = num(); haveCustom = true; }
+        else {
+            std::fprintf(stderr, "unknown option %s\n", a.c_str());
+            return 2;
+        }
+    }
+
+    std::vector<CorpusShape> shapes = haveCustom ? std::vector<CorpusShape>{custom} : defaultCorpusShapes();
+    std::vector<ShapeResult> results;
+    for (auto& s : shapes) {
+        s.seed = seed;
+        if (scale > 0 && scale != 1.0)
+            s.functions = std::max<size_t>(1, static_cast<size_t>(static_cast<double>(s.functions) * scale));
+        results.push_back(runShape(s, reps));
+    }
+
+    printTable(results, reps);
+    if (jsonPath) {
+        bool toStdout = std::strcmp(jsonPath, "-") == 0;
+        FILE* f = toStdout ? stdout : std::fopen(jsonPath, "w");
+        if (!f) {
+            std::fprintf(stderr, "cannot write %s\n", jsonPath);
+            return 1;
+        }
+        writeJson(f, results, reps);
+        if (!toStdout) std::fclose(f);
+    }
+    for (const auto& r : results)
+        if (!r.parsed) return 1;
+    return 0;
+}
@@ -0,0 +1,107 @@
+#include "Ast.h"
+#include <cstring>
+#include <ostream>
+#include <string>
+
+// ----- literal payloads -----
+static void setBits(AstNode& n, std::uint64_t bits) {
+    n.a = static_cast<std::uint32_t>(bits);
+    n.b = static_cast<std::uint32_t>(bits >> 32);
+}
+static std::uint64_t bits(const AstNode& n) {
+    return (static_cast<std::uint64_t>(n.b) << 32) | n.a;
+}
+
+void setIntValue(AstNode& n, std::int64_t v) { setBits(n, static_cast<std::uint64_t>(v)); }
+std::int64_t intValue(const AstNode& n) { return static_cast<std::int64_t>(bits(n)); }
+
+void setRealValue(AstNode& n, double v) {
+    std::uint64_t b;
+    std::memcpy(&b, &v, sizeof b);
+    setBits(n, b);
+}
+double realValue(const AstNode& n) {
+    std::uint64_t b = bits(n);
+    double v;
+    std::memcpy(&v, &b, sizeof v);
+    return v;
+}
+
+// ----- dump -----
+static const char* kindName(NodeKind k) {
+    switch (k) {
+        case NodeKind::Program:    return "Program";
+        case NodeKind::Function:   return "Function";
+        case NodeKind::Param:      return "Param";
+        case NodeKind::Decl:       return "Decl";
+        case NodeKind::Compound:   return "Compound";
+        case NodeKind::Assign:     return "Assign";
+        case NodeKind::If:         return "If";
+        case NodeKind::While:      return "While";
+        case NodeKind::Return:     return "Return";
+        case NodeKind::Print:      return "Print";
+        case NodeKind::Scan:       return "Scan";
+        case NodeKind::Relational: return "Relational";
+        case NodeKind::Binary:     return "Binary";
+        case NodeKind::Neg:        return "Neg";
+        case NodeKind::Ident:      return "Ident";
+        case NodeKind::Call:       return "Call";
+        case NodeKind::IntLit:     return "IntLit";
+        case NodeKind::RealLit:    return "RealLit";
+        case NodeKind::BoolLit:    return "BoolLit";
+        case NodeKind::StringLit:  return "StringLit";
+    }
+    return "?";
+}
+
+static void dumpNode(const ParseResult& r, NodeId id, int depth, std::ostream& os);
+
+static void dumpList(const ParseResult& r, NodeId head, int depth, std::ostream& os) {
+    for (NodeId n = head; n; n = r[n].next) dumpNode(r, n, depth, os);
+}
+
+static void dumpNode(const ParseResult& r, NodeId id, int depth, std::ostream& os) {
+    if (!id) return;   // e.g. a statement dropped by error recovery
+    const AstNode& n = r[id];
+    os << std::string(depth * 2, ' ') << kindName(n.kind);
+    switch (n.kind) {
+        case NodeKind::Function: case NodeKind::Assign:
+        case NodeKind::Ident:    case NodeKind::Call:
+            os << ' ' << r.names.name(n.a); break;
+        case NodeKind::Param: case NodeKind::Decl:
+            os << ' ' << r.names.name(n.a) << " : " << tokIdText(n.op); break;
+        case NodeKind::Relational: case NodeKind::Binary: case NodeKind::BoolLit:
+            os << ' ' << tokIdText(n.op); break;
+        case NodeKind::IntLit:    os << ' ' << intValue(n); break;
+        case NodeKind::RealLit:   os << ' ' << realValue(n); break;
+        case NodeKind::StringLit: os << " \"" << r.names.name(n.a) << '"'; break;
+        default: break;
+    }
+    os << "\n";
+
+    const int in = depth + 1;
+    switch (n.kind) {
+        case NodeKind::Program:
+            dumpList(r, n.a, in, os); dumpList(r, n.b, in, os); dumpList(r, n.c, in, os); break;
+        case NodeKind::Function:
+            dumpList(r, n.b, in, os); dumpList(r, n.c, in, os); dumpList(r, n.d, in, os); break;
+        case NodeKind::Compound: case NodeKind::Scan:
+            dumpList(r, n.a, in, os); break;
+        case NodeKind::Assign: case NodeKind::Call:
+            dumpList(r, n.b, in, os); break;
+        case NodeKind::If:
+            dumpNode(r, n.a, in, os); dumpNode(r, n.b, in, os);
+            if (n.c) dumpNode(r, n.c, in, os);
+            break;
+        case NodeKind::While: case NodeKind::Relational: case NodeKind::Binary:
+            dumpNode(r, n.a, in, os); dumpNode(r, n.b, in, os); break;
+        case NodeKind::Return: case NodeKind::Print: case NodeKind::Neg:
+            if (n.a) dumpNode(r, n.a, in, os);
+            break;
+        default: break;
+    }
+}
+
+void dumpAst(const ParseResult& r, std::ostream& os) {
+    if (r.root) dumpNode(r, r.root, 0, os);
+}
@@ -0,0 +1,90 @@
+// Ast.h
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+#include "Interner.h"
+#include "Token.h"
+
+// Index into ParseResult::nodes; 0 is the reserved "no node".
+using NodeId = std::uint32_t;
+
+enum class NodeKind : std::uint8_t {
+    Program, Function, Param, Decl,
+    // statements
+    Compound, Assign, If, While, Return, Print, Scan,
+    // expressions
+    Relational, Binary, Neg, Ident, Call, IntLit, RealLit, BoolLit, StringLit
+};
+
+// One fixed-size node per construct; children are NodeIds, names are Interner
+// IDs, and every list is chained through `next`.
+//   Program    a=functions  b=decls  c=statements
+//   Function   a=name  b=params  c=decls  d=body statements
+//   Param/Decl a=name  op=qualifier keyword
+//   Compound   a=statements
+//   Assign     a=target name  b=expr
+//   If         a=condition  b=then  c=else (0 if none)
+//   While      a=condition  b=body
+//   Return     a=expr (0 if none)
+//   Print      a=expr
+//   Scan       a=Ident list
+//   Relational op=relop  a=lhs  b=rhs
+//   Binary     op=Plus/Minus/Star/Slash  a=lhs  b=rhs
+//   Neg        a=operand
+//   Ident      a=name
+//   Call       a=name  b=Ident list (arguments)
+//   IntLit     a/b=low/high 32 bits of the value
+//   RealLit    a/b=low/high 32 bits of the double
+//   BoolLit    op=True/False
+//   StringLit  a=interned text
+struct AstNode {
+    NodeKind kind{};
+    TokId op = TokId::None;
+    std::uint16_t reserved = 0;
+    std::uint32_t a = 0, b = 0, c = 0, d = 0;
+    NodeId next = 0;
+    std::uint32_t line = 0, col = 0;   // position of the node's first token
+};
+static_assert(sizeof(AstNode) == 32, "keep AstNode at 32 bytes");
+
+// Owns the whole tree: nodes are bump-allocated at the end of one vector, so
+// dropping (or clear()ing) a result frees every node at once.
+struct ParseResult {
+    std::vector<AstNode> nodes{1};   // nodes[0] = "no node"
+    Interner names;                  // identifiers and string literals
+    NodeId root = 0;
+
+    NodeId add(NodeKind kind, std::uint32_t line, std::uint32_t col) {
+        nodes.push_back({});
+        AstNode& n = nodes.back();
+        n.kind = kind; n.line = line; n.col = col;
+        return static_cast<NodeId>(nodes.size() - 1);
+    }
+    AstNode& operator[](NodeId id) { return nodes[id]; }
+    const AstNode& operator[](NodeId id) const { return nodes[id]; }
+
+    size_t nodeCount() const { return nodes.size() - 1; }
+    void clear() { nodes.resize(1); names.clear(); root = 0; }   // keeps capacity
+};
+
+// head/tail of a `next`-chained list under construction; appending a chain
+// (e.g. the Params of `a, b integer`) links all of it
+struct NodeList {
+    NodeId head = 0, tail = 0;
+    void append(ParseResult& r, NodeId n) {
+        if (!n) return;
+        if (tail) r[tail].next = n; else head = n;
+        tail = n;
+        while (r[tail].next) tail = r[tail].next;
+    }
+};
+
+// literal payloads split across a/b
+void setIntValue(AstNode& n, std::int64_t v);
+void setRealValue(AstNode& n, double v);
+std::int64_t intValue(const AstNode& n);
+double realValue(const AstNode& n);
+
+// indented one-node-per-line dump, for debugging
+void dumpAst(const ParseResult& r, std::ostream& os);
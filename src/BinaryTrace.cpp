@@ -0,0 +1,178 @@
+// BinaryTrace.cpp
+#include "BinaryTrace.h"
+#include <cstring>
+#include "TokenCache.h"
+
+namespace {
+static_assert(kProdCount <= trace_tag::kToken, "Prod values fit below the tags");
+static_assert(static_cast<unsigned>(TokenType::EndOfFile) < 0x10, "kinds fit in a tag's low nibble");
+
+std::uint64_t zigzag(std::int64_t v) { return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63); }
+std::int64_t unzigzag(std::uint64_t v) { return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1); }
+
+// reads records off the trace; every read fails cleanly at the end
+struct Reader {
+    const unsigned char* p;
+    const unsigned char* end;
+    bool byte(std::uint8_t& out) {
+        if (p == end) return false;
+        out = *p++;
+        return true;
+    }
+    bool varint(std::uint64_t& out) {
+        out = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            std::uint8_t b;
+            if (!byte(b)) return false;
+            out |= std::uint64_t{b & 0x7Fu} << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    }
+    bool bytes(size_t n, std::string_view& out) {
+        if (static_cast<size_t>(end - p) < n) return false;
+        out = { reinterpret_cast<const char*>(p), n };
+        p += n;
+        return true;
+    }
+};
+} // namespace
+
+// ------------ BinaryTraceSink ------------
+BinaryTraceSink::BinaryTraceSink(const std::string& path, std::string_view source, size_t capacity)
+    : BufferedFileSink(path, capacity), source_(source) {
+    header();
+}
+
+BinaryTraceSink::BinaryTraceSink(int fd, std::string_view source, size_t capacity)
+    : BufferedFileSink(fd, capacity), source_(source) {
+    header();
+}
+
+void BinaryTraceSink::header() {
+    BinaryTraceHeader h{};
+    std::memcpy(h.magic, kBinaryTraceMagic, sizeof h.magic);
+    h.version = kBinaryTraceVersion;
+    h.hasSource = source_.data() != nullptr && !source_.empty();
+    h.sourceHash = h.hasSource ? hashSource(source_) : 0;
+    h.sourceSize = source_.size();
+    append(std::string_view(reinterpret_cast<const char*>(&h), sizeof h));
+}
+
+void BinaryTraceSink::varint(std::uint64_t v) {
+    while (v >= 0x80) {
+        buf_.push_back(static_cast<char>(v | 0x80));
+        v >>= 7;
+    }
+    buf_.push_back(static_cast<char>(v));
+}
+
+void BinaryTraceSink::emit(std::string_view line) {
+    buf_.push_back(static_cast<char>(trace_tag::kLine));
+    varint(line.size());
+    append(line);
+    maybeFlush();
+}
+
+void BinaryTraceSink::token(const Token& t) {
+    const auto kind = static_cast<std::uint8_t>(t.type);
+    const char* base = source_.data();
+    const bool inSource = !source_.empty() && t.lexeme.data() >= base &&
+                          t.lexeme.data() + t.lexeme.size() <= base + source_.size();
+    // a sub-kind's spelling has a fixed length (keywords only differ in case)
+    const bool implied = t.id == TokId::None || t.lexeme.size() == std::strlen(tokIdText(t.id));
+    if (inSource && implied) {
+        const auto offset = static_cast<size_t>(t.lexeme.data() - base);
+        buf_.push_back(static_cast<char>(trace_tag::kToken | kind));
+        buf_.push_back(static_cast<char>(t.id));
+        varint(zigzag(static_cast<std::int64_t>(offset) - static_cast<std::int64_t>(prevEnd_)));
+        if (t.id == TokId::None) varint(t.lexeme.size());
+        prevEnd_ = offset + t.lexeme.size();
+    } else {
+        buf_.push_back(static_cast<char>(trace_tag::kTokenText | kind));
+        buf_.push_back(static_cast<char>(t.id));
+        varint(t.lexeme.size());
+        append(t.lexeme);
+    }
+    maybeFlush();
+}
+
+void BinaryTraceSink::relop(const Token& op) {
+    if (op.id == TokId::None || op.lexeme != tokIdText(op.id)) { ProductionSink::relop(op); return; }
+    buf_.push_back(static_cast<char>(trace_tag::kRelop));
+    buf_.push_back(static_cast<char>(op.id));
+    maybeFlush();
+}
+
+// ------------ decoder ------------
+bool decodeTrace(std::string_view trace, std::string_view source, ProductionSink& out, std::string& error) {
+    BinaryTraceHeader h;
+    if (trace.size() < sizeof h) { error = "not a binary trace (too short)"; return false; }
+    std::memcpy(&h, trace.data(), sizeof h);
+    if (std::memcmp(h.magic, kBinaryTraceMagic, sizeof h.magic) != 0) { error = "not a binary trace"; return false; }
+    if (h.version != kBinaryTraceVersion) { error = "unsupported trace version " + std::to_string(h.version); return false; }
+    if (h.hasSource && source.empty()) { error = "the trace needs the source it was written for"; return false; }
+    if (h.hasSource && (source.size() != h.sourceSize || hashSource(source) != h.sourceHash)) {
+        error = "trace was written for a different source";
+        return false;
+    }
+
+    Reader in{ reinterpret_cast<const unsigned char*>(trace.data()) + sizeof h,
+               reinterpret_cast<const unsigned char*>(trace.data()) + trace.size() };
+    size_t prevEnd = 0;
+    for (;;) {
+        const size_t at = static_cast<size_t>(in.p - reinterpret_cast<const unsigned char*>(trace.data()));
+        std::uint8_t tag;
+        if (!in.byte(tag)) return true;
+        const auto bad = [&](const char* what) {
+            error = std::string(what) + " at byte " + std::to_string(at);
+            return false;
+        };
+        if (tag < trace_tag::kToken) {
+            if (tag >= kProdCount) return bad("unknown production");
+            out.production(static_cast<Prod>(tag));
+            continue;
+        }
+        std::uint8_t id = 0;
+        std::uint64_t n = 0;
+        std::string_view lexeme;
+        const unsigned kind = tag & 0x0Fu;
+        switch (tag & 0xF0u) {
+            case trace_tag::kToken: {
+                if (!h.hasSource) return bad("token offset in a trace without source");
+                if (kind > static_cast<unsigned>(TokenType::EndOfFile)) return bad("unknown token kind");
+                if (!in.byte(id) || !in.varint(n)) return bad("truncated token");
+                if (id >= static_cast<std::uint8_t>(TokId::Count)) return bad("unknown token id");
+                const std::int64_t offset = static_cast<std::int64_t>(prevEnd) + unzigzag(n);
+                std::uint64_t len = std::strlen(tokIdText(static_cast<TokId>(id)));
+                if (id == static_cast<std::uint8_t>(TokId::None) && !in.varint(len)) return bad("truncated token");
+                if (offset < 0 || static_cast<std::uint64_t>(offset) > source.size() ||
+                    len > source.size() - static_cast<size_t>(offset))
+                    return bad("token outside the source");
+                lexeme = source.substr(static_cast<size_t>(offset), static_cast<size_t>(len));
+                prevEnd = static_cast<size_t>(offset) + lexeme.size();
+                break;
+            }
+            case trace_tag::kTokenText:
+                if (kind > static_cast<unsigned>(TokenType::EndOfFile)) return bad("unknown token kind");
+                if (!in.byte(id) || !in.varint(n) || !in.bytes(static_cast<size_t>(n), lexeme)) return bad("truncated token");
+                if (id >= static_cast<std::uint8_t>(TokId::Count)) return bad("unknown token id");
+                break;
+            default:
+                if (tag == trace_tag::kRelop) {
+                    if (!in.byte(id)) return bad("truncated relop");
+                    if (id == 0 || id >= static_cast<std::uint8_t>(TokId::Count)) return bad("unknown relop id");
+                    const auto op = static_cast<TokId>(id);
+                    out.relop({ TokenType::Operator, op, tokIdText(op), 0, 0 });
+                    continue;
+                }
+                if (tag == trace_tag::kLine) {
+                    if (!in.varint(n) || !in.bytes(static_cast<size_t>(n), lexeme)) return bad("truncated line");
+                    out.emit(lexeme);
+                    continue;
+                }
+                return bad("unknown record");
+        }
+        out.token({ static_cast<TokenType>(kind), static_cast<TokId>(id), lexeme, 0, 0 });
+    }
+}
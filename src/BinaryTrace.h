@@ -0,0 +1,72 @@
+// BinaryTrace.h
+// Compact trace: what the text sinks would print, as records of a byte or
+// a few instead of a line each. A production is its Prod value (1 byte); an
+// echoed token is its kind, sub-kind and source offset, the lexeme being read
+// back out of the source when the trace is decoded (tracedump, tools/). The
+// decoder replays the records into any ProductionSink, so its text is the
+// same as a text trace's byte for byte.
+//
+// Layout (little-endian): BinaryTraceHeader, then records
+//   0x00..0xBF   production (the Prod value)
+//   0xC0 | kind  token in the source: id, varint offset delta from the end of
+//                the previous one (zigzag, so it may step back); then a varint
+//                length if id is None (keyword, operator and separator
+//                lengths follow from the id)
+//   0xD0 | kind  token given as text: id, varint length, the lexeme bytes
+//   0xE0         <Relop> line: the operator's id
+//   0xE1         any other line (errors, the verdict): varint length, bytes
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "Sink.h"
+
+inline constexpr char kBinaryTraceMagic[8] = { 'R', '2', '5', 'F', 'T', 'R', 'C', '\0' };
+inline constexpr std::uint32_t kBinaryTraceVersion = 1;
+
+struct BinaryTraceHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t hasSource;      // 0: every token is stored as text
+    std::uint64_t sourceHash;     // hashSource() of the traced source
+    std::uint64_t sourceSize;
+};
+static_assert(sizeof(BinaryTraceHeader) == 32, "on-disk layout");
+
+namespace trace_tag {
+inline constexpr std::uint8_t kToken = 0xC0;
+inline constexpr std::uint8_t kTokenText = 0xD0;
+inline constexpr std::uint8_t kRelop = 0xE0;
+inline constexpr std::uint8_t kLine = 0xE1;
+} // namespace trace_tag
+
+// A BufferedFileSink writing records instead of text. Tokens whose lexeme
+// does not lie in `source` (token caches, stdin windows) go in as text;
+// with an empty source all of them do.
+class BinaryTraceSink : public BufferedFileSink {
+public:
+    static constexpr size_t kDefaultCapacity = size_t{4} << 20;
+
+    BinaryTraceSink(const std::string& path, std::string_view source, size_t capacity = kDefaultCapacity);
+    BinaryTraceSink(int fd, std::string_view source, size_t capacity = kDefaultCapacity);
+
+    void emit(std::string_view line) override;
+    void production(Prod p) override { buf_.push_back(static_cast<char>(p)); maybeFlush(); }
+    void token(const Token& t) override;
+    void relop(const Token& op) override;
+    void error(std::string_view msg) override { emit(msg); }
+    void write(std::string_view text) override { ProductionSink::write(text); }
+
+private:
+    void header();
+    void varint(std::uint64_t v);
+
+    std::string_view source_;
+    size_t prevEnd_ = 0;          // source offset just past the last token stored
+};
+
+// Replays `trace` into `out`. `source` must be the traced file unless the
+// trace has none. False with a reason in `error` if the trace is malformed,
+// truncated, or was written for a different source.
+bool decodeTrace(std::string_view trace, std::string_view source, ProductionSink& out, std::string& error);
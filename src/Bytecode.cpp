@@ -0,0 +1,25 @@
+// Bytecode.cpp
+#include "Bytecode.h"
+#include <ostream>
+
+const char* opName(Op op) {
+    switch (op) {
+#define RAT25F_OP_NAME(name) case Op::name: return #name;
+        RAT25F_OPCODES(RAT25F_OP_NAME)
+#undef RAT25F_OP_NAME
+        case Op::Count: break;
+    }
+    return "?";
+}
+
+void dumpModule(const Module& m, std::ostream& os) {
+    for (size_t i = 0; i < m.functions.size(); ++i) {
+        const BcFunction& f = m.functions[i];
+        os << "function " << i << ' ' << f.name << ": params " << f.params << ", locals " << f.locals
+           << ", consts " << f.consts.size() << ", frame " << f.frameSize << "\n";
+        for (size_t pc = 0; pc < f.code.size(); ++pc) {
+            const Insn& in = f.code[pc];
+            os << "  " << pc << '\t' << opName(in.op) << ' ' << in.a << ' ' << in.b << ' ' << in.c << "\n";
+        }
+    }
+}
@@ -0,0 +1,87 @@
+// Bytecode.h
+// Register bytecode for running Rat25F programs: Compiler.h builds a Module
+// from the AST, Vm.h executes it. Types are settled at compile time, so every
+// slot is an untagged 8-byte Value and every instruction is typed (AddI vs
+// AddR); conditions compile to one compare-and-branch.
+//
+// A call frame is one window of the VM's register stack:
+//   [0, params)          arguments
+//   [params, locals)     declared variables (zeroed on entry)
+//   [locals, + consts)   this function's constants (copied in on entry)
+//   [.., frameSize)      temporaries
+// Program-level variables live outside the frames (LoadG / StoreG).
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+enum class ValueType : std::uint8_t { Void, Integer, Real, Boolean };
+
+// booleans are i = 0 / 1
+union Value {
+    std::int64_t i;
+    double r;
+};
+static_assert(sizeof(Value) == 8);
+
+// X(name): a, b are registers unless noted; c is a register, a jump target
+// (instruction index) or a table index
+#define RAT25F_OPCODES(X) \
+    X(Move)      /* a = b */                                  \
+    X(IntToReal) /* a = real(b) */                            \
+    X(LoadG)     /* a = globals[c] */                         \
+    X(StoreG)    /* globals[c] = a */                         \
+    X(AddI) X(SubI) X(MulI) X(DivI)   /* a = b op c */        \
+    X(AddR) X(SubR) X(MulR) X(DivR)                           \
+    X(NegI) X(NegR)                   /* a = -b */            \
+    X(Jmp)                            /* pc = c */            \
+    /* if (a rel b) pc = c; > and >= swap the operands */     \
+    X(JLtI) X(JLeI) X(JEqI) X(JNeI)                           \
+    X(JLtR) X(JLeR) X(JEqR) X(JNeR)                           \
+    X(JNLtR) X(JNLeR)   /* if !(a rel b): exact for NaN */    \
+    X(Call)      /* a = functions[c](b, b+1, ...) */          \
+    X(Ret)       /* return a */                               \
+    X(RetVoid)   /* the entry's return ends the program */    \
+    X(PutI) X(PutR) X(PutB)   /* print a */                   \
+    X(PutS)      /* print strings[c] */                       \
+    X(GetI) X(GetR) X(GetB)   /* read a */
+
+enum class Op : std::uint8_t {
+#define RAT25F_OP_ENUM(name) name,
+    RAT25F_OPCODES(RAT25F_OP_ENUM)
+#undef RAT25F_OP_ENUM
+    Count
+};
+
+struct Insn {
+    Op op;
+    std::uint8_t reserved = 0;
+    std::uint16_t a = 0, b = 0;
+    std::uint16_t reserved2 = 0;
+    std::uint32_t c = 0;
+};
+static_assert(sizeof(Insn) == 12, "keep Insn at 12 bytes");
+
+struct BcFunction {
+    std::string name;
+    std::vector<Insn> code;
+    std::vector<std::uint32_t> lines;   // source line of each instruction
+    std::vector<Value> consts;          // copied to [locals, locals + consts.size())
+    std::vector<ValueType> paramTypes;
+    ValueType returnType = ValueType::Void;
+    std::uint16_t params = 0, locals = 0;
+    std::uint32_t frameSize = 0;        // registers a call needs
+};
+
+struct Module {
+    std::vector<BcFunction> functions;
+    std::vector<std::string> strings;   // PutS operands
+    std::vector<ValueType> globals;
+    std::uint32_t entry = 0;            // the program's statements, or a call of main()
+};
+
+const char* opName(Op op);
+// one instruction per line, per function (debugging, like dumpAst)
+void dumpModule(const Module& m, std::ostream& os);
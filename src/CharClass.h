@@ -0,0 +1,37 @@
+// CharClass.h
+#pragma once
+#include <array>
+#include <cstdint>
+
+// One byte of class bits per input byte; drives the Lexer dispatcher and FSMs.
+namespace cc {
+constexpr std::uint8_t Space     = 1 << 0;  // ' ' \t \n \v \f \r
+constexpr std::uint8_t Letter    = 1 << 1;  // A-Z a-z
+constexpr std::uint8_t Digit     = 1 << 2;  // 0-9
+constexpr std::uint8_t IdentRest = 1 << 3;  // letter, digit, '$', '_'
+constexpr std::uint8_t Separator = 1 << 4;  // ( ) { } [ ] , ;
+constexpr std::uint8_t OpStart   = 1 << 5;  // + - * / = < > ! & |
+constexpr std::uint8_t Quote     = 1 << 6;  // "
+constexpr std::uint8_t Dot       = 1 << 7;  // .
+} // namespace cc
+
+inline constexpr std::array<std::uint8_t, 256> kCharClass = [] {
+    std::array<std::uint8_t, 256> t{};
+    for (int c : { ' ', '\t', '\n', '\v', '\f', '\r' }) t[c] |= cc::Space;
+    for (int c = 'A'; c <= 'Z'; ++c) t[c] |= cc::Letter | cc::IdentRest;
+    for (int c = 'a'; c <= 'z'; ++c) t[c] |= cc::Letter | cc::IdentRest;
+    for (int c = '0'; c <= '9'; ++c) t[c] |= cc::Digit | cc::IdentRest;
+    t['$'] |= cc::IdentRest;
+    t['_'] |= cc::IdentRest;
+    for (int c : { '(', ')', '{', '}', '[', ']', ',', ';' }) t[c] |= cc::Separator;
+    for (int c : { '+', '-', '*', '/', '=', '<', '>', '!', '&', '|' }) t[c] |= cc::OpStart;
+    t['"'] |= cc::Quote;
+    t['.'] |= cc::Dot;
+    return t;
+}();
+
+inline constexpr std::uint8_t charClass(char c) { return kCharClass[static_cast<unsigned char>(c)]; }
+inline constexpr bool hasClass(char c, std::uint8_t bits) { return (charClass(c) & bits) != 0; }
+
+static_assert(hasClass('_', cc::IdentRest) && !hasClass('_', cc::Letter));
+static_assert(hasClass('\n', cc::Space) && !hasClass('\xA0', cc::Space));
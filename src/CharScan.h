@@ -0,0 +1,198 @@
+// CharScan.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include "CharClass.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RAT25F_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+// Run finders for the Lexer FSMs. Each returns the first byte in [p, end)
+// that is NOT in the class (quoteRun: the first '"', asciiEnd: the first
+// byte >= 0x80); whole 16/32-byte
+// blocks are tested at once and the tail falls back to the kCharClass table.
+namespace scan {
+
+struct SpaceRun {
+    const char* end;        // first byte past the run (or input end)
+    const char* lastNl;     // last '\n' inside the run, nullptr if none
+    std::size_t newlines;   // number of '\n' inside the run
+};
+
+namespace detail {
+inline unsigned ctz32(std::uint32_t m) { return static_cast<unsigned>(__builtin_ctz(m)); }
+inline unsigned clz32(std::uint32_t m) { return static_cast<unsigned>(__builtin_clz(m)); }
+inline unsigned pop32(std::uint32_t m) { return static_cast<unsigned>(__builtin_popcount(m)); }
+
+inline void noteNewlines(SpaceRun& r, const char* block, std::uint32_t nl) {
+    if (!nl) return;
+    r.newlines += pop32(nl);
+    r.lastNl = block + (31 - clz32(nl));
+}
+
+#if defined(__AVX2__)
+constexpr std::size_t kBlock = 32;
+using Vec = __m256i;
+inline Vec load(const char* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+inline Vec splat(char c) { return _mm256_set1_epi8(c); }
+inline Vec eq(Vec a, char c) { return _mm256_cmpeq_epi8(a, splat(c)); }
+inline Vec orv(Vec a, Vec b) { return _mm256_or_si256(a, b); }
+inline Vec andv(Vec a, Vec b) { return _mm256_and_si256(a, b); }
+// signed compares: bytes >= 0x80 are negative and never fall in an ASCII range
+inline Vec inRange(Vec a, char lo, char hi) {
+    return andv(_mm256_cmpgt_epi8(a, splat(static_cast<char>(lo - 1))),
+                _mm256_cmpgt_epi8(splat(static_cast<char>(hi + 1)), a));
+}
+inline std::uint32_t mask(Vec a) { return static_cast<std::uint32_t>(_mm256_movemask_epi8(a)); }
+inline Vec highMask(Vec a) { return a; }   // movemask already takes the top bits
+constexpr std::uint32_t kFull = 0xFFFFFFFFu;
+#define RAT25F_SIMD 1
+#elif defined(RAT25F_SSE2)
+constexpr std::size_t kBlock = 16;
+using Vec = __m128i;
+inline Vec load(const char* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+inline Vec splat(char c) { return _mm_set1_epi8(c); }
+inline Vec eq(Vec a, char c) { return _mm_cmpeq_epi8(a, splat(c)); }
+inline Vec orv(Vec a, Vec b) { return _mm_or_si128(a, b); }
+inline Vec andv(Vec a, Vec b) { return _mm_and_si128(a, b); }
+inline Vec inRange(Vec a, char lo, char hi) {
+    return andv(_mm_cmpgt_epi8(a, splat(static_cast<char>(lo - 1))),
+                _mm_cmplt_epi8(a, splat(static_cast<char>(hi + 1))));
+}
+inline std::uint32_t mask(Vec a) { return static_cast<std::uint32_t>(_mm_movemask_epi8(a)); }
+inline Vec highMask(Vec a) { return a; }
+constexpr std::uint32_t kFull = 0xFFFFu;
+#define RAT25F_SIMD 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+constexpr std::size_t kBlock = 16;
+using Vec = int8x16_t;
+inline Vec load(const char* p) { return vld1q_s8(reinterpret_cast<const int8_t*>(p)); }
+inline Vec splat(char c) { return vdupq_n_s8(static_cast<int8_t>(c)); }
+inline Vec eq(Vec a, char c) { return vreinterpretq_s8_u8(vceqq_s8(a, splat(c))); }
+inline Vec orv(Vec a, Vec b) { return vorrq_s8(a, b); }
+inline Vec andv(Vec a, Vec b) { return vandq_s8(a, b); }
+inline Vec inRange(Vec a, char lo, char hi) {
+    return vreinterpretq_s8_u8(vandq_u8(vcgeq_s8(a, splat(lo)), vcleq_s8(a, splat(hi))));
+}
+// bit i of the result = top bit of byte i (movemask emulation)
+inline std::uint32_t mask(Vec a) {
+    static const uint8_t kBits[16] = { 1,2,4,8,16,32,64,128, 1,2,4,8,16,32,64,128 };
+    uint8x16_t m = vandq_u8(vreinterpretq_u8_s8(a), vld1q_u8(kBits));
+    return static_cast<std::uint32_t>(vaddv_u8(vget_low_u8(m))) |
+           (static_cast<std::uint32_t>(vaddv_u8(vget_high_u8(m))) << 8);
+}
+inline Vec highMask(Vec a) { return vreinterpretq_s8_u8(vcltzq_s8(a)); }
+constexpr std::uint32_t kFull = 0xFFFFu;
+#define RAT25F_SIMD 1
+#endif
+
+#ifdef RAT25F_SIMD
+inline Vec spaceMask(Vec v) { return orv(eq(v, ' '), inRange(v, '\t', '\r')); }
+inline Vec identMask(Vec v) {
+    Vec lower = orv(v, splat(0x20));
+    return orv(orv(inRange(lower, 'a', 'z'), inRange(v, '0', '9')),
+               orv(eq(v, '$'), eq(v, '_')));
+}
+#endif
+} // namespace detail
+
+inline SpaceRun spaceRun(const char* p, const char* end) {
+    SpaceRun r{ p, nullptr, 0 };
+#ifdef RAT25F_SIMD
+    using namespace detail;
+    while (static_cast<std::size_t>(end - p) >= kBlock) {
+        Vec v = load(p);
+        std::uint32_t ws = mask(spaceMask(v));
+        std::uint32_t nl = mask(eq(v, '\n'));
+        if (ws != kFull) {
+            unsigned stop = ctz32(~ws);
+            noteNewlines(r, p, nl & ((1u << stop) - 1));
+            r.end = p + stop;
+            return r;
+        }
+        noteNewlines(r, p, nl);
+        p += kBlock;
+    }
+#endif
+    while (p < end && hasClass(*p, cc::Space)) {
+        if (*p == '\n') { r.newlines++; r.lastNl = p; }
+        ++p;
+    }
+    r.end = p;
+    return r;
+}
+
+// string body: up to the closing quote, counting the newlines on the way so
+// a multi-line banner costs one pass
+inline SpaceRun quoteRun(const char* p, const char* end) {
+    SpaceRun r{ p, nullptr, 0 };
+#ifdef RAT25F_SIMD
+    using namespace detail;
+    while (static_cast<std::size_t>(end - p) >= kBlock) {
+        Vec v = load(p);
+        std::uint32_t q = mask(eq(v, '"'));
+        std::uint32_t nl = mask(eq(v, '\n'));
+        if (q) {
+            unsigned stop = ctz32(q);
+            noteNewlines(r, p, nl & ((1u << stop) - 1));
+            r.end = p + stop;
+            return r;
+        }
+        noteNewlines(r, p, nl);
+        p += kBlock;
+    }
+#endif
+    while (p < end && *p != '"') {
+        if (*p == '\n') { r.newlines++; r.lastNl = p; }
+        ++p;
+    }
+    r.end = p;
+    return r;
+}
+
+inline const char* identEnd(const char* p, const char* end) {
+#ifdef RAT25F_SIMD
+    using namespace detail;
+    while (static_cast<std::size_t>(end - p) >= kBlock) {
+        std::uint32_t m = mask(identMask(load(p)));
+        if (m != kFull) return p + ctz32(~m);
+        p += kBlock;
+    }
+#endif
+    while (p < end && hasClass(*p, cc::IdentRest)) ++p;
+    return p;
+}
+
+inline const char* asciiEnd(const char* p, const char* end) {
+#ifdef RAT25F_SIMD
+    using namespace detail;
+    while (static_cast<std::size_t>(end - p) >= kBlock) {
+        std::uint32_t m = mask(highMask(load(p)));
+        if (m) return p + ctz32(m);
+        p += kBlock;
+    }
+#endif
+    while (p < end && static_cast<unsigned char>(*p) < 0x80) ++p;
+    return p;
+}
+
+inline const char* digitEnd(const char* p, const char* end) {
+#ifdef RAT25F_SIMD
+    using namespace detail;
+    while (static_cast<std::size_t>(end - p) >= kBlock) {
+        std::uint32_t m = mask(inRange(load(p), '0', '9'));
+        if (m != kFull) return p + ctz32(~m);
+        p += kBlock;
+    }
+#endif
+    while (p < end && hasClass(*p, cc::Digit)) ++p;
+    return p;
+}
+
+} // namespace scan
@@ -0,0 +1,602 @@
+// Compiler.cpp
+#include "Compiler.h"
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+namespace {
+
+constexpr std::uint32_t kMaxRegisters = 0xFFFF;   // Insn register fields are 16-bit
+
+struct Var {
+    ValueType type;
+    bool global;
+    std::uint32_t slot;   // register, or index into Module::globals
+};
+
+// where an expression's value is: a variable, a constant or a temporary
+struct Operand {
+    ValueType type;
+    std::uint16_t reg;
+};
+
+struct FnInfo {
+    NodeId node;
+    std::vector<ValueType> params;
+    std::optional<ValueType> ret;   // unset until a return statement settles it
+};
+
+ValueType qualifierType(TokId q) {
+    switch (q) {
+        case TokId::Real:    return ValueType::Real;
+        case TokId::Boolean: return ValueType::Boolean;
+        default:             return ValueType::Integer;   // integer / int
+    }
+}
+
+const char* typeName(ValueType t) {
+    switch (t) {
+        case ValueType::Void:    return "no value";
+        case ValueType::Integer: return "integer";
+        case ValueType::Real:    return "real";
+        case ValueType::Boolean: return "boolean";
+    }
+    return "?";
+}
+
+bool numeric(ValueType t) { return t == ValueType::Integer || t == ValueType::Real; }
+
+std::uint64_t bitsOf(Value v) {
+    std::uint64_t b;
+    std::memcpy(&b, &v, sizeof b);
+    return b;
+}
+
+class Compiler {
+public:
+    Compiler(const ParseResult& ast, const Module* resultTypes) : ast_(ast), resultTypes_(resultTypes) {}
+    Module run();
+
+private:
+    [[noreturn]] void fail(const std::string& what, const AstNode& at) const;
+    std::string quoted(std::uint32_t name) const { return "'" + std::string(ast_.names.name(name)) + "'"; }
+    const AstNode& node(NodeId n) const { return ast_[n]; }
+
+    // ----- names and types -----
+    void collect();
+    void openScope(const FnInfo* fn);   // its params and declarations; null = the program
+    const Var& lookup(std::uint32_t name, const AstNode& at) const;
+    const FnInfo& callee(const AstNode& call, std::uint32_t* index = nullptr) const;
+    std::optional<ValueType> typeOf(NodeId e) const;
+    std::optional<ValueType> binaryType(const AstNode& n, std::optional<ValueType> l, std::optional<ValueType> r) const;
+    void returnTypes(NodeId stmt, std::optional<ValueType>& ret) const;
+    void inferReturnTypes();
+
+    // ----- code -----
+    void beginFunction(BcFunction& f, NodeId body);
+    void endFunction();
+    void constants(NodeId n);
+    std::uint16_t constant(Value v);
+    std::uint16_t intConstant(std::int64_t v) { Value x; x.i = v; return constant(x); }
+    std::uint16_t realConstant(double v) { Value x; x.r = v; return constant(x); }
+    std::uint16_t temp();
+    std::uint32_t emit(Op op, std::uint32_t a = 0, std::uint32_t b = 0, std::uint32_t c = 0);
+    std::uint32_t here() const { return static_cast<std::uint32_t>(fn_->code.size()); }
+    void patch(std::uint32_t at) { fn_->code[at].c = here(); }
+
+    void statements(NodeId head);
+    void statement(NodeId n);
+    void assign(const Var& v, NodeId e, const AstNode& at);
+    std::uint32_t branch(NodeId cond, bool when);
+    Operand expr(NodeId e);
+    Operand exprTo(NodeId e, std::uint16_t dst);
+    Operand toReal(Operand o);
+    Operand call(const AstNode& n, std::uint16_t dst);
+
+    const ParseResult& ast_;
+    const Module* resultTypes_;       // see compileProgram()
+    Module mod_;
+    std::vector<FnInfo> fns_;
+    std::unordered_map<std::uint32_t, std::uint32_t> fnIndex_;   // name -> fns_ / Module::functions
+    std::unordered_map<std::uint32_t, Var> globals_, locals_;
+    const FnInfo* scope_ = nullptr;   // function being compiled, null for the entry
+
+    BcFunction* fn_ = nullptr;
+    std::unordered_map<std::uint64_t, std::uint16_t> consts_;   // Value bits -> register
+    std::uint32_t firstTemp_ = 0, nextTemp_ = 0;
+    std::uint32_t line_ = 0;          // of the statement being compiled
+};
+
+void Compiler::fail(const std::string& what, const AstNode& at) const {
+    throw std::runtime_error("Compile error: " + what + " at line " + std::to_string(at.line) +
+                             ", col " + std::to_string(at.col));
+}
+
+// ------------ names and types ------------
+void Compiler::collect() {
+    const AstNode& prog = node(ast_.root);
+    for (NodeId f = prog.a; f; f = node(f).next) {
+        const AstNode& fn = node(f);
+        if (!fnIndex_.emplace(fn.a, static_cast<std::uint32_t>(fns_.size())).second)
+            fail("duplicate function " + quoted(fn.a), fn);
+        FnInfo info{ f, {}, std::nullopt };
+        for (NodeId p = fn.b; p; p = node(p).next) info.params.push_back(qualifierType(node(p).op));
+        fns_.push_back(std::move(info));
+    }
+    for (NodeId d = prog.b; d; d = node(d).next) {
+        const AstNode& decl = node(d);
+        const Var v{ qualifierType(decl.op), true, static_cast<std::uint32_t>(mod_.globals.size()) };
+        if (!globals_.emplace(decl.a, v).second) fail("duplicate declaration of " + quoted(decl.a), decl);
+        mod_.globals.push_back(v.type);
+    }
+}
+
+void Compiler::openScope(const FnInfo* fn) {
+    scope_ = fn;
+    locals_.clear();
+    if (!fn) return;
+    const AstNode& f = node(fn->node);
+    std::uint32_t reg = 0;
+    for (NodeId list : { f.b, f.c }) {   // params, then declarations
+        for (NodeId d = list; d; d = node(d).next) {
+            const AstNode& v = node(d);
+            if (!locals_.emplace(v.a, Var{ qualifierType(v.op), false, reg++ }).second)
+                fail("duplicate declaration of " + quoted(v.a), v);
+        }
+    }
+    if (reg > kMaxRegisters) fail("too many variables in " + quoted(f.a), f);
+}
+
+const Var& Compiler::lookup(std::uint32_t name, const AstNode& at) const {
+    if (auto it = locals_.find(name); it != locals_.end()) return it->second;
+    if (auto it = globals_.find(name); it != globals_.end()) return it->second;
+    fail("undeclared identifier " + quoted(name), at);
+}
+
+const FnInfo& Compiler::callee(const AstNode& call, std::uint32_t* index) const {
+    auto it = fnIndex_.find(call.a);
+    if (it == fnIndex_.end()) fail("undeclared function " + quoted(call.a), call);
+    const FnInfo& f = fns_[it->second];
+    size_t argc = 0;
+    for (NodeId a = call.b; a; a = node(a).next) ++argc;
+    if (argc != f.params.size())
+        fail("function " + quoted(call.a) + " expects " + std::to_string(f.params.size()) +
+             " argument(s), got " + std::to_string(argc), call);
+    if (index) *index = it->second;
+    return f;
+}
+
+std::optional<ValueType> Compiler::binaryType(const AstNode& n, std::optional<ValueType> l,
+                                              std::optional<ValueType> r) const {
+    if ((l && !numeric(*l)) || (r && !numeric(*r)))
+        fail(std::string("operator '") + tokIdText(n.op) + "' needs numbers, got " +
+             typeName(l && !numeric(*l) ? *l : *r), n);
+    if (!l || !r) return std::nullopt;
+    return *l == ValueType::Real || *r == ValueType::Real ? ValueType::Real : ValueType::Integer;
+}
+
+// nullopt: a call to a function whose result type is not settled yet
+std::optional<ValueType> Compiler::typeOf(NodeId e) const {
+    const AstNode& n = node(e);
+    switch (n.kind) {
+        case NodeKind::Ident:   return lookup(n.a, n).type;
+        case NodeKind::IntLit:  return ValueType::Integer;
+        case NodeKind::RealLit: return ValueType::Real;
+        case NodeKind::BoolLit: return ValueType::Boolean;
+        case NodeKind::Neg:     return binaryType(n, typeOf(n.a), ValueType::Integer);
+        case NodeKind::Binary:  return binaryType(n, typeOf(n.a), typeOf(n.b));
+        case NodeKind::Call:    return callee(n).ret;
+        case NodeKind::StringLit: fail("a string can only be printed", n);
+        default:                fail("not an expression", n);
+    }
+}
+
+void Compiler::returnTypes(NodeId s, std::optional<ValueType>& ret) const {
+    if (!s) return;
+    const AstNode& n = node(s);
+    switch (n.kind) {
+        case NodeKind::Compound:
+            for (NodeId c = n.a; c; c = node(c).next) returnTypes(c, ret);
+            break;
+        case NodeKind::If:
+            returnTypes(n.b, ret);
+            returnTypes(n.c, ret);
+            break;
+        case NodeKind::While:
+            returnTypes(n.b, ret);
+            break;
+        case NodeKind::Return: {
+            if (!n.a) break;
+            const std::optional<ValueType> t = typeOf(n.a);
+            if (!t) break;
+            if (!ret || *ret == *t) ret = *t;
+            else if (numeric(*ret) && numeric(*t)) ret = ValueType::Real;
+            else fail(std::string("function returns both ") + typeName(*ret) + " and " + typeName(*t), n);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// results only widen (unset -> integer -> real), so this settles
+void Compiler::inferReturnTypes() {
+    if (resultTypes_) {
+        // the folder keeps every function, in order
+        for (size_t i = 0; i < fns_.size(); ++i) fns_[i].ret = resultTypes_->functions[i].returnType;
+        return;
+    }
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (FnInfo& f : fns_) {
+            openScope(&f);
+            std::optional<ValueType> ret = f.ret;
+            for (NodeId s = node(f.node).d; s; s = node(s).next) returnTypes(s, ret);
+            if (ret != f.ret) { f.ret = ret; changed = true; }
+        }
+    }
+    for (FnInfo& f : fns_) if (!f.ret) f.ret = ValueType::Void;
+}
+
+// ------------ code ------------
+void Compiler::beginFunction(BcFunction& f, NodeId body) {
+    fn_ = &f;
+    consts_.clear();
+    f.locals = static_cast<std::uint16_t>(locals_.size());
+    // constants take the registers after the locals, so collect them first
+    intConstant(0);
+    realConstant(0.0);
+    for (NodeId s = body; s; s = node(s).next) constants(s);
+    firstTemp_ = nextTemp_ = f.locals + static_cast<std::uint32_t>(f.consts.size());
+    f.frameSize = firstTemp_;
+}
+
+void Compiler::endFunction() {
+    if (fn_->frameSize > kMaxRegisters) {
+        const AstNode& at = scope_ ? node(scope_->node) : node(ast_.root);
+        fail("function needs too many registers", at);
+    }
+    fn_ = nullptr;
+}
+
+void Compiler::constants(NodeId s) {
+    if (!s) return;
+    const AstNode& n = node(s);
+    switch (n.kind) {
+        case NodeKind::IntLit:
+            // also as a real, so an integer literal in a real expression is free
+            intConstant(intValue(n));
+            realConstant(static_cast<double>(intValue(n)));
+            return;
+        case NodeKind::RealLit: realConstant(realValue(n)); return;
+        case NodeKind::BoolLit: intConstant(n.op == TokId::True); return;
+        case NodeKind::Compound:
+            for (NodeId c = n.a; c; c = node(c).next) constants(c);
+            return;
+        case NodeKind::Assign:     constants(n.b); return;
+        case NodeKind::If:         constants(n.a); constants(n.b); constants(n.c); return;
+        case NodeKind::While:      constants(n.a); constants(n.b); return;
+        case NodeKind::Return:     constants(n.a); return;
+        case NodeKind::Print:      constants(n.a); return;
+        case NodeKind::Relational:
+        case NodeKind::Binary:     constants(n.a); constants(n.b); return;
+        case NodeKind::Neg:        constants(n.a); return;
+        default: return;
+    }
+}
+
+std::uint16_t Compiler::constant(Value v) {
+    const auto [it, added] = consts_.emplace(bitsOf(v), 0);
+    if (added) {
+        if (fn_->locals + fn_->consts.size() >= kMaxRegisters) fail("too many constants", node(ast_.root));
+        it->second = static_cast<std::uint16_t>(fn_->locals + fn_->consts.size());
+        fn_->consts.push_back(v);
+    }
+    return it->second;
+}
+
+std::uint16_t Compiler::temp() {
+    const std::uint32_t r = nextTemp_++;
+    if (nextTemp_ > fn_->frameSize) fn_->frameSize = nextTemp_;
+    if (r >= kMaxRegisters) fail("expression needs too many registers", node(ast_.root));
+    return static_cast<std::uint16_t>(r);
+}
+
+std::uint32_t Compiler::emit(Op op, std::uint32_t a, std::uint32_t b, std::uint32_t c) {
+    Insn i{ op };
+    i.a = static_cast<std::uint16_t>(a);
+    i.b = static_cast<std::uint16_t>(b);
+    i.c = c;
+    fn_->code.push_back(i);
+    fn_->lines.push_back(line_);
+    return here() - 1;
+}
+
+void Compiler::statements(NodeId head) {
+    for (NodeId s = head; s; s = node(s).next) statement(s);
+}
+
+void Compiler::statement(NodeId s) {
+    const AstNode& n = node(s);
+    line_ = n.line;
+    nextTemp_ = firstTemp_;   // temporaries only live within a statement
+    switch (n.kind) {
+        case NodeKind::Compound:
+            statements(n.a);
+            break;
+        case NodeKind::Assign:
+            assign(lookup(n.a, n), n.b, n);
+            break;
+        case NodeKind::If: {
+            const std::uint32_t skip = branch(n.a, false);
+            statement(n.b);
+            if (n.c) {
+                const std::uint32_t over = emit(Op::Jmp);
+                patch(skip);
+                statement(n.c);
+                patch(over);
+            } else {
+                patch(skip);
+            }
+            break;
+        }
+        case NodeKind::While: {
+            // test at the bottom: one branch per iteration
+            const std::uint32_t enter = emit(Op::Jmp);
+            const std::uint32_t body = here();
+            statement(n.b);
+            patch(enter);
+            line_ = n.line;
+            nextTemp_ = firstTemp_;
+            fn_->code[branch(n.a, true)].c = body;
+            break;
+        }
+        case NodeKind::Return: {
+            const ValueType ret = scope_ ? *scope_->ret : ValueType::Void;
+            if (ret == ValueType::Void) {
+                // a value whose type never settled: only unbounded recursion leaves one
+                if (n.a) fail(scope_ ? "cannot infer the result type of " + quoted(node(scope_->node).a)
+                                     : std::string("return with a value outside a function"), n);
+                emit(Op::RetVoid);
+                break;
+            }
+            if (!n.a) { emit(Op::Ret, ret == ValueType::Real ? realConstant(0.0) : intConstant(0)); break; }
+            Operand o = expr(n.a);
+            if (ret == ValueType::Real && o.type == ValueType::Integer) o = toReal(o);
+            emit(Op::Ret, o.reg);
+            break;
+        }
+        case NodeKind::Print: {
+            const AstNode& e = node(n.a);
+            if (e.kind == NodeKind::StringLit) {
+                emit(Op::PutS, 0, 0, static_cast<std::uint32_t>(mod_.strings.size()));
+                mod_.strings.emplace_back(ast_.names.name(e.a));
+                break;
+            }
+            const Operand o = expr(n.a);
+            emit(o.type == ValueType::Real ? Op::PutR : o.type == ValueType::Boolean ? Op::PutB : Op::PutI, o.reg);
+            break;
+        }
+        case NodeKind::Scan:
+            for (NodeId i = n.a; i; i = node(i).next) {
+                const AstNode& id = node(i);
+                const Var& v = lookup(id.a, id);
+                const Op op = v.type == ValueType::Real ? Op::GetR : v.type == ValueType::Boolean ? Op::GetB : Op::GetI;
+                if (!v.global) { emit(op, v.slot); continue; }
+                const std::uint16_t t = temp();
+                emit(op, t);
+                emit(Op::StoreG, t, 0, v.slot);
+            }
+            break;
+        default:
+            fail("not a statement", n);
+    }
+}
+
+void Compiler::assign(const Var& v, NodeId e, const AstNode& at) {
+    const ValueType t = *typeOf(e);
+    if (t != v.type && !(v.type == ValueType::Real && t == ValueType::Integer))
+        fail(std::string("cannot assign ") + typeName(t) + " to " + typeName(v.type) + " " + quoted(at.a), at);
+    Operand o;
+    if (v.global || t != v.type) {
+        o = expr(e);
+        if (t != v.type) {
+            if (v.global) o = toReal(o);
+            else { emit(Op::IntToReal, v.slot, o.reg); return; }
+        }
+    } else {
+        o = exprTo(e, static_cast<std::uint16_t>(v.slot));
+    }
+    if (v.global) emit(Op::StoreG, o.reg, 0, v.slot);
+}
+
+// emits the branch taken when the condition's truth == `when`; the caller patches c
+std::uint32_t Compiler::branch(NodeId cond, bool when) {
+    const AstNode& n = node(cond);
+    if (n.kind != NodeKind::Relational) fail("condition expected", n);
+    Operand l = expr(n.a), r = expr(n.b);
+    TokId rel = n.op;
+    if (l.type == ValueType::Boolean || r.type == ValueType::Boolean) {
+        if (l.type != r.type || (rel != TokId::EqEq && rel != TokId::NotEq))
+            fail(std::string("cannot compare ") + typeName(l.type) + " " + tokIdText(rel) + " " + typeName(r.type), n);
+    } else if (l.type != r.type) {
+        l = toReal(l);
+        r = toReal(r);
+    }
+
+    if (l.type != ValueType::Real) {
+        // integers (and booleans): the negation is another comparison
+        if (!when) {
+            switch (rel) {
+                case TokId::Less:      rel = TokId::GreaterEq; break;
+                case TokId::LessEq:    rel = TokId::Greater; break;
+                case TokId::Greater:   rel = TokId::LessEq; break;
+                case TokId::GreaterEq: rel = TokId::Less; break;
+                case TokId::EqEq:      rel = TokId::NotEq; break;
+                default:               rel = TokId::EqEq; break;
+            }
+        }
+        switch (rel) {
+            case TokId::Less:      return emit(Op::JLtI, l.reg, r.reg);
+            case TokId::LessEq:    return emit(Op::JLeI, l.reg, r.reg);
+            case TokId::Greater:   return emit(Op::JLtI, r.reg, l.reg);
+            case TokId::GreaterEq: return emit(Op::JLeI, r.reg, l.reg);
+            case TokId::EqEq:      return emit(Op::JEqI, l.reg, r.reg);
+            default:               return emit(Op::JNeI, l.reg, r.reg);
+        }
+    }
+    // reals: !(a < b) is not b <= a once a NaN is involved
+    switch (rel) {
+        case TokId::Less:      return emit(when ? Op::JLtR : Op::JNLtR, l.reg, r.reg);
+        case TokId::LessEq:    return emit(when ? Op::JLeR : Op::JNLeR, l.reg, r.reg);
+        case TokId::Greater:   return emit(when ? Op::JLtR : Op::JNLtR, r.reg, l.reg);
+        case TokId::GreaterEq: return emit(when ? Op::JLeR : Op::JNLeR, r.reg, l.reg);
+        case TokId::EqEq:      return emit(when ? Op::JEqR : Op::JNeR, l.reg, r.reg);
+        default:               return emit(when ? Op::JNeR : Op::JEqR, l.reg, r.reg);
+    }
+}
+
+Operand Compiler::expr(NodeId e) {
+    const AstNode& n = node(e);
+    switch (n.kind) {
+        case NodeKind::Ident: {
+            const Var& v = lookup(n.a, n);
+            if (!v.global) return { v.type, static_cast<std::uint16_t>(v.slot) };
+            const std::uint16_t t = temp();
+            emit(Op::LoadG, t, 0, v.slot);
+            return { v.type, t };
+        }
+        case NodeKind::IntLit:  return { ValueType::Integer, intConstant(intValue(n)) };
+        case NodeKind::RealLit: return { ValueType::Real, realConstant(realValue(n)) };
+        case NodeKind::BoolLit: return { ValueType::Boolean, intConstant(n.op == TokId::True) };
+        case NodeKind::Binary:
+        case NodeKind::Neg:
+        case NodeKind::Call:    return exprTo(e, temp());
+        case NodeKind::StringLit: fail("a string can only be printed", n);
+        default:                fail("not an expression", n);
+    }
+}
+
+// computes e into dst; dst is only written by the last instruction, so it
+// may be a variable the expression reads
+Operand Compiler::exprTo(NodeId e, std::uint16_t dst) {
+    const AstNode& n = node(e);
+    switch (n.kind) {
+        case NodeKind::Binary: {
+            Operand l = expr(n.a), r = expr(n.b);
+            const ValueType t = *binaryType(n, l.type, r.type);
+            if (t == ValueType::Real) { l = toReal(l); r = toReal(r); }
+            Op op;
+            switch (n.op) {
+                case TokId::Plus:  op = t == ValueType::Real ? Op::AddR : Op::AddI; break;
+                case TokId::Minus: op = t == ValueType::Real ? Op::SubR : Op::SubI; break;
+                case TokId::Star:  op = t == ValueType::Real ? Op::MulR : Op::MulI; break;
+                default:           op = t == ValueType::Real ? Op::DivR : Op::DivI; break;
+            }
+            emit(op, dst, l.reg, r.reg);
+            return { t, dst };
+        }
+        case NodeKind::Neg: {
+            const Operand o = expr(n.a);
+            const ValueType t = *binaryType(n, o.type, ValueType::Integer);
+            emit(t == ValueType::Real ? Op::NegR : Op::NegI, dst, o.reg);
+            return { t, dst };
+        }
+        case NodeKind::Call:
+            return call(n, dst);
+        case NodeKind::Ident:
+            if (const Var& v = lookup(n.a, n); v.global) {
+                emit(Op::LoadG, dst, 0, v.slot);
+                return { v.type, dst };
+            }
+            [[fallthrough]];
+        default: {
+            const Operand o = expr(e);
+            if (o.reg != dst) emit(Op::Move, dst, o.reg);
+            return { o.type, dst };
+        }
+    }
+}
+
+Operand Compiler::toReal(Operand o) {
+    if (o.type != ValueType::Integer) return o;
+    // a constant's real twin exists already (constants())
+    const std::uint32_t k = o.reg - fn_->locals;
+    if (o.reg >= fn_->locals && k < fn_->consts.size() && o.reg < firstTemp_)
+        return { ValueType::Real, realConstant(static_cast<double>(fn_->consts[k].i)) };
+    const std::uint16_t t = temp();
+    emit(Op::IntToReal, t, o.reg);
+    return { ValueType::Real, t };
+}
+
+Operand Compiler::call(const AstNode& n, std::uint16_t dst) {
+    std::uint32_t index = 0;
+    const FnInfo& f = callee(n, &index);
+    if (*f.ret == ValueType::Void) fail("function " + quoted(n.a) + " returns no value", n);
+    // arguments go to consecutive registers, converted to the parameter types
+    const std::uint32_t base = nextTemp_;
+    for (size_t i = 0; i < f.params.size(); ++i) temp();
+    size_t i = 0;
+    for (NodeId a = n.b; a; a = node(a).next, ++i) {
+        const auto to = static_cast<std::uint16_t>(base + i);
+        const ValueType t = *typeOf(a);
+        if (t == f.params[i])                                            exprTo(a, to);
+        else if (f.params[i] == ValueType::Real && t == ValueType::Integer) emit(Op::IntToReal, to, expr(a).reg);
+        else fail("argument " + std::to_string(i + 1) + " of " + quoted(n.a) + " must be " +
+                  typeName(f.params[i]) + ", got " + typeName(t), node(a));
+    }
+    emit(Op::Call, dst, base, index);
+    return { *f.ret, dst };
+}
+
+Module Compiler::run() {
+    if (!ast_.root || node(ast_.root).kind != NodeKind::Program) throw std::runtime_error("Compile error: no program");
+    collect();
+    inferReturnTypes();
+
+    mod_.functions.resize(fns_.size() + 1);
+    for (size_t i = 0; i < fns_.size(); ++i) {
+        const FnInfo& info = fns_[i];
+        const AstNode& f = node(info.node);
+        BcFunction& out = mod_.functions[i];
+        out.name = ast_.names.name(f.a);
+        out.paramTypes = info.params;
+        out.returnType = *info.ret;
+        out.params = static_cast<std::uint16_t>(info.params.size());
+        openScope(&info);
+        beginFunction(out, f.d);
+        statements(f.d);
+        // falling off the end returns nothing / zero
+        line_ = f.line;
+        if (out.returnType == ValueType::Void) emit(Op::RetVoid);
+        else emit(Op::Ret, out.returnType == ValueType::Real ? realConstant(0.0) : intConstant(0));
+        endFunction();
+    }
+
+    // the entry: the program's statements, else main()
+    const AstNode& prog = node(ast_.root);
+    mod_.entry = static_cast<std::uint32_t>(fns_.size());
+    BcFunction& entry = mod_.functions.back();
+    entry.name = "<program>";
+    openScope(nullptr);
+    beginFunction(entry, prog.c);
+    statements(prog.c);
+    if (!prog.c) {
+        for (std::uint32_t i = 0; i < fns_.size(); ++i) {
+            if (mod_.functions[i].name != "main" || !fns_[i].params.empty()) continue;
+            emit(Op::Call, temp(), 0, i);
+            break;
+        }
+    }
+    emit(Op::RetVoid);
+    endFunction();
+    return std::move(mod_);
+}
+
+} // namespace
+
+Module compileProgram(const ParseResult& ast, const Module* resultTypes) {
+    return Compiler(ast, resultTypes).run();
+}
@@ -0,0 +1,22 @@
+// Compiler.h
+// AST (Parser::parse(start, out)) -> bytecode Module (Bytecode.h).
+//
+// Typing: integer / int, real and boolean come from the declarations; an
+// integer goes wherever a real is expected, nothing else converts. Functions
+// declare no result type, so each one's is inferred from its return
+// statements (to a fixed point, for calls between functions). `/` on two
+// integers divides as integers. Strings can only be printed.
+//
+// The entry runs the program's own statements; a program that has none runs
+// main() instead, if it defines one without parameters.
+#pragma once
+#include "Ast.h"
+#include "Bytecode.h"
+
+// Throws std::runtime_error ("Compile error: <what> at line L, col C") for
+// type errors, unknown names and arity mismatches.
+//
+// `resultTypes`: a module compiled from this tree before foldConstants()
+// (Fold.h) changed it. Its function result types are used as they are, not
+// inferred again, so a return the folder dropped cannot narrow one.
+Module compileProgram(const ParseResult& ast, const Module* resultTypes = nullptr);
@@ -0,0 +1,128 @@
+// Diagnostic.cpp
+#include "Diagnostic.h"
+#include <charconv>
+#include <cstring>
+
+static void appendNumber(std::string& out, std::uint32_t v) {
+    char buf[10];
+    out.append(buf, std::to_chars(buf, buf + sizeof buf, v).ptr);
+}
+
+static void appendQuoted(std::string& out, std::string_view s) {
+    out += '\'';
+    out += s;
+    out += '\'';
+}
+
+void Diagnostic::formatTo(std::string& out) const {
+    const bool syntax = code < DiagCode::DuplicateDeclaration;
+    out += syntax ? "Syntax error: " : "Semantic error: ";
+    switch (code) {
+        case DiagCode::ExpectedIdentifier: out += "identifier expected"; break;
+        case DiagCode::ExpectedKeyword:    appendQuoted(out, tokIdText(expected)); out += " expected"; break;
+        case DiagCode::ExpectedOperator:
+            out += "operator ";
+            appendQuoted(out, tokIdText(expected));
+            out += " expected";
+            break;
+        case DiagCode::ExpectedSeparator:
+            out += "separator ";
+            appendQuoted(out, tokIdText(expected));
+            out += " expected";
+            break;
+        case DiagCode::ExpectedQualifier:    out += "qualifier (integer|boolean|real) expected"; break;
+        case DiagCode::ExpectedStatement:    out += "statement expected"; break;
+        case DiagCode::ExpectedRelop:        out += "relational operator expected"; break;
+        case DiagCode::ExpectedPrimary:      out += "primary expected"; break;
+        case DiagCode::ExpectedEndOfSegment: out += "end of function segment expected"; break;
+        case DiagCode::NestingTooDeep:
+            out += "nesting too deep (limit ";
+            appendNumber(out, count);
+            out += ')';
+            break;
+        case DiagCode::DuplicateDeclaration: out += "duplicate declaration of "; appendQuoted(out, text); break;
+        case DiagCode::UndeclaredIdentifier: out += "undeclared identifier "; appendQuoted(out, text); break;
+        case DiagCode::UndeclaredFunction:   out += "undeclared function "; appendQuoted(out, text); break;
+        case DiagCode::DuplicateFunction:    out += "duplicate function "; appendQuoted(out, text); break;
+        case DiagCode::ArityMismatch:
+            out += "function ";
+            appendQuoted(out, text);
+            out += " expects ";
+            appendNumber(out, count);
+            out += " argument(s), got ";
+            appendNumber(out, got);
+            break;
+    }
+    out += " at line ";
+    appendNumber(out, line);
+    out += ", col ";
+    appendNumber(out, col);
+    if (syntax) {
+        out += " (near ";
+        appendQuoted(out, text);
+        out += ')';
+    }
+}
+
+// ----- DiagnosticList -----
+DiagnosticList& DiagnosticList::operator=(const DiagnosticList& o) {
+    if (this == &o) return *this;
+    clear();
+    items_.reserve(o.items_.size());
+    for (const Diagnostic& d : o.items_) push_back(d);
+    return *this;
+}
+
+DiagnosticList& DiagnosticList::operator=(DiagnosticList&& o) noexcept {
+    items_ = std::move(o.items_);
+    current_ = std::move(o.current_);
+    full_ = std::move(o.full_);
+    free_ = std::exchange(o.free_, nullptr);
+    left_ = std::exchange(o.left_, 0);
+    o.items_.clear();
+    o.full_.clear();
+    return *this;
+}
+
+void DiagnosticList::push_back(const Diagnostic& d) {
+    items_.push_back(d);
+    items_.back().text = keep(d.text);
+}
+
+void DiagnosticList::clear() {
+    items_.clear();
+    full_.clear();
+    free_ = current_.get();
+    left_ = current_ ? kBlock : 0;
+}
+
+std::string_view DiagnosticList::keep(std::string_view s) {
+    if (s.empty()) return {};
+    if (s.size() > left_) {
+        if (s.size() > kBlock / 4) {
+            // a long lexeme gets a block of its own; the current one goes on
+            full_.push_back(std::make_unique<char[]>(s.size()));
+            std::memcpy(full_.back().get(), s.data(), s.size());
+            return { full_.back().get(), s.size() };
+        }
+        if (current_) full_.push_back(std::move(current_));
+        current_ = std::make_unique<char[]>(kBlock);
+        free_ = current_.get();
+        left_ = kBlock;
+    }
+    char* p = free_;
+    std::memcpy(p, s.data(), s.size());
+    free_ += s.size();
+    left_ -= s.size();
+    return { p, s.size() };
+}
+
+// ----- ParseError -----
+const char* ParseError::what() const noexcept {
+    try {
+        if (message.empty()) diag.formatTo(message);
+        return message.c_str();
+    } catch (...) {
+        return "parse error";
+    }
+}
@@ -0,0 +1,85 @@
+// Diagnostic.h
+// A parse error as a small value: what went wrong, where, and the one piece
+// of source text its message quotes (the lexeme near a syntax error, the
+// name in a semantic one). Nothing is formatted when it is recorded; the
+// text is only built by formatTo() once a sink wants it, so a broken input
+// with thousands of errors costs a push_back per error, not a string build.
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "Token.h"
+
+enum class DiagCode : std::uint8_t {
+    // "Syntax error: <what> at line L, col C (near '<text>')"
+    ExpectedIdentifier, ExpectedKeyword, ExpectedOperator, ExpectedSeparator,   // expected = the TokId
+    ExpectedQualifier, ExpectedStatement, ExpectedRelop, ExpectedPrimary,
+    ExpectedEndOfSegment,
+    NestingTooDeep,                                                             // count = the limit
+    // "Semantic error: <what> at line L, col C"; text = the name
+    DuplicateDeclaration, UndeclaredIdentifier, UndeclaredFunction, DuplicateFunction,
+    ArityMismatch                                                               // count = arity, got = argc
+};
+
+struct Diagnostic {
+    DiagCode code{};
+    TokId expected = TokId::None;
+    std::uint32_t line = 0, col = 0;
+    std::uint32_t count = 0, got = 0;
+    // the lexer's input or the parse's names while it is reported; a
+    // DiagnosticList's own copy once stored there
+    std::string_view text;
+
+    // appends the message the parse would have thrown (no newline)
+    void formatTo(std::string& out) const;
+    std::string message() const { std::string s; formatTo(s); return s; }
+};
+
+// Diagnostics, and the text they quote copied into blocks the list owns:
+// a block holds many, so storing one allocates nothing of its own. Blocks
+// never move, so the views stay valid until clear() or the list goes.
+class DiagnosticList {
+public:
+    DiagnosticList() = default;
+    DiagnosticList(const DiagnosticList& o) { *this = o; }
+    DiagnosticList(DiagnosticList&& o) noexcept { *this = std::move(o); }
+    DiagnosticList& operator=(const DiagnosticList& o);
+    DiagnosticList& operator=(DiagnosticList&& o) noexcept;
+
+    void push_back(const Diagnostic& d);   // copies d.text
+    void clear();                          // keeps the block being filled
+    void reserve(size_t n) { items_.reserve(n); }
+
+    size_t size() const { return items_.size(); }
+    bool empty() const { return items_.empty(); }
+    const Diagnostic& operator[](size_t i) const { return items_[i]; }
+    auto begin() const { return items_.begin(); }
+    auto end() const { return items_.end(); }
+
+private:
+    static constexpr size_t kBlock = 4096;
+    std::string_view keep(std::string_view s);
+
+    std::vector<Diagnostic> items_;
+    std::unique_ptr<char[]> current_;                // kBlock bytes, being filled
+    std::vector<std::unique_ptr<char[]>> full_;      // filled ones and long texts
+    char* free_ = nullptr;                           // in current_
+    size_t left_ = 0;
+};
+
+// What Parser and LL1Parser throw. Carries the unformatted Diagnostic:
+// recovery records it as is, and only an error that leaves the parse is
+// turned into text (once, by what()). The parse settle()s one before it
+// leaves, while the text it quotes is still there.
+struct ParseError : std::exception {
+    explicit ParseError(Diagnostic d) : diag(d) {}
+    const char* what() const noexcept override;
+    void settle() { if (message.empty()) diag.formatTo(message); diag.text = {}; }
+    Diagnostic diag;
+    mutable std::string message;
+};
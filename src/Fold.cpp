@@ -0,0 +1,333 @@
+// Fold.cpp
+#include "Fold.h"
+#include <cmath>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+namespace {
+
+enum class Ty : std::uint8_t { Unknown, Integer, Real, Boolean };
+
+// which of a, b, c, d hold child node lists (bit 0 = a)
+unsigned childFields(NodeKind k) {
+    switch (k) {
+        case NodeKind::Program:    return 0b0111;
+        case NodeKind::Function:   return 0b1110;
+        case NodeKind::Compound:   return 0b0001;
+        case NodeKind::Assign:     return 0b0010;
+        case NodeKind::If:         return 0b0111;
+        case NodeKind::While:      return 0b0011;
+        case NodeKind::Return:     return 0b0001;
+        case NodeKind::Print:      return 0b0001;
+        case NodeKind::Scan:       return 0b0001;
+        case NodeKind::Relational: return 0b0011;
+        case NodeKind::Binary:     return 0b0011;
+        case NodeKind::Neg:        return 0b0001;
+        case NodeKind::Call:       return 0b0010;
+        default:                   return 0;
+    }
+}
+
+template <class Node>   // AstNode or const AstNode
+auto& field(Node& n, unsigned i) {
+    switch (i) {
+        case 0:  return n.a;
+        case 1:  return n.b;
+        case 2:  return n.c;
+        default: return n.d;
+    }
+}
+
+size_t countList(const ParseResult& r, NodeId head) {
+    size_t n = 0;
+    for (NodeId id = head; id; id = r[id].next) {
+        ++n;
+        for (unsigned i = 0, m = childFields(r[id].kind); m; ++i, m >>= 1)
+            if (m & 1) n += countList(r, field(r[id], i));
+    }
+    return n;
+}
+
+// copies the reachable nodes of `from` into `to`, in the same preorder the
+// parser allocated them in
+NodeId copyList(const ParseResult& from, ParseResult& to, NodeId head) {
+    NodeList out;
+    for (NodeId id = head; id; id = from[id].next) {
+        AstNode n = from[id];
+        n.next = 0;
+        to.nodes.push_back(n);
+        const NodeId copy = static_cast<NodeId>(to.nodes.size() - 1);
+        for (unsigned i = 0, m = childFields(n.kind); m; ++i, m >>= 1)
+            if (m & 1) field(to[copy], i) = copyList(from, to, field(n, i));
+        out.append(to, copy);
+    }
+    return out.head;
+}
+
+class Folder {
+public:
+    explicit Folder(ParseResult& r) : r_(r) {}
+    void program();
+
+private:
+    AstNode& at(NodeId n) { return r_[n]; }
+    static Ty declared(TokId q) {
+        return q == TokId::Real ? Ty::Real : q == TokId::Boolean ? Ty::Boolean : Ty::Integer;
+    }
+    void declare(std::unordered_map<std::uint32_t, Ty>& scope, NodeId list);
+    Ty typeOf(NodeId e);
+
+    NodeId statements(NodeId head);
+    NodeId statement(NodeId s);   // replacement; 0 = nothing left
+    NodeId slot(NodeId s);        // as statement(), but never 0 (an empty Compound)
+    NodeId expr(NodeId e);
+    std::optional<bool> condition(NodeId c);
+
+    ParseResult& r_;
+    std::unordered_map<std::uint32_t, Ty> globals_, locals_;
+};
+
+void Folder::declare(std::unordered_map<std::uint32_t, Ty>& scope, NodeId list) {
+    for (NodeId d = list; d; d = at(d).next) scope[at(d).a] = declared(at(d).op);
+}
+
+Ty Folder::typeOf(NodeId e) {
+    const AstNode& n = at(e);
+    switch (n.kind) {
+        case NodeKind::IntLit:  return Ty::Integer;
+        case NodeKind::RealLit: return Ty::Real;
+        case NodeKind::BoolLit: return Ty::Boolean;
+        case NodeKind::Ident:
+            if (auto it = locals_.find(n.a); it != locals_.end()) return it->second;
+            if (auto it = globals_.find(n.a); it != globals_.end()) return it->second;
+            return Ty::Unknown;
+        case NodeKind::Neg: {
+            const Ty t = typeOf(n.a);
+            return t == Ty::Integer || t == Ty::Real ? t : Ty::Unknown;
+        }
+        case NodeKind::Binary: {
+            const Ty l = typeOf(n.a), r = typeOf(n.b);
+            if ((l != Ty::Integer && l != Ty::Real) || (r != Ty::Integer && r != Ty::Real)) return Ty::Unknown;
+            return l == Ty::Real || r == Ty::Real ? Ty::Real : Ty::Integer;
+        }
+        default:
+            return Ty::Unknown;   // calls: result types are the compiler's business
+    }
+}
+
+void Folder::program() {
+    AstNode& prog = at(r_.root);
+    declare(globals_, prog.b);
+    for (NodeId f = prog.a; f; f = at(f).next) {
+        locals_.clear();
+        declare(locals_, at(f).b);
+        declare(locals_, at(f).c);
+        const NodeId body = statements(at(f).d);
+        at(f).d = body;
+    }
+    locals_.clear();
+    const NodeId stmts = statements(at(r_.root).c);
+    at(r_.root).c = stmts;
+}
+
+NodeId Folder::statements(NodeId head) {
+    NodeList out;
+    for (NodeId s = head; s;) {
+        const NodeId next = at(s).next;
+        const NodeId kept = statement(s);
+        if (kept) {
+            at(kept).next = 0;
+            out.append(r_, kept);
+        }
+        s = next;
+    }
+    return out.head;
+}
+
+NodeId Folder::slot(NodeId s) {
+    if (const NodeId kept = statement(s)) return kept;
+    // the dropped statement's own node becomes the empty placeholder
+    AstNode& n = at(s);
+    n.kind = NodeKind::Compound;
+    n.op = TokId::None;
+    n.a = n.b = n.c = n.d = 0;
+    return s;
+}
+
+NodeId Folder::statement(NodeId s) {
+    if (!s) return 0;
+    const NodeKind kind = at(s).kind;
+    switch (kind) {
+        case NodeKind::Compound: {
+            const NodeId body = statements(at(s).a);
+            at(s).a = body;
+            return s;
+        }
+        case NodeKind::Assign: {
+            const NodeId e = expr(at(s).b);
+            at(s).b = e;
+            return s;
+        }
+        case NodeKind::Return:
+        case NodeKind::Print:
+            if (at(s).a) { const NodeId e = expr(at(s).a); at(s).a = e; }
+            return s;
+        case NodeKind::If: {
+            const std::optional<bool> c = condition(at(s).a);
+            if (c) return statement(*c ? at(s).b : at(s).c);
+            const NodeId then = slot(at(s).b);
+            at(s).b = then;
+            if (at(s).c) { const NodeId other = slot(at(s).c); at(s).c = other; }
+            return s;
+        }
+        case NodeKind::While: {
+            const std::optional<bool> c = condition(at(s).a);
+            if (c && !*c) return 0;
+            const NodeId body = slot(at(s).b);
+            at(s).b = body;
+            return s;
+        }
+        default:
+            return s;   // Scan
+    }
+}
+
+// folds both sides; the value when both are literals
+std::optional<bool> Folder::condition(NodeId c) {
+    if (at(c).kind != NodeKind::Relational) return std::nullopt;
+    { const NodeId l = expr(at(c).a); at(c).a = l; }
+    { const NodeId r = expr(at(c).b); at(c).b = r; }
+    const AstNode& n = at(c);
+    const AstNode& l = at(n.a);
+    const AstNode& r = at(n.b);
+    const TokId op = n.op;
+    auto compare = [op](auto x, auto y) {
+        switch (op) {
+            case TokId::Less:      return x < y;
+            case TokId::LessEq:    return x <= y;
+            case TokId::Greater:   return x > y;
+            case TokId::GreaterEq: return x >= y;
+            case TokId::EqEq:      return x == y;
+            default:               return x != y;
+        }
+    };
+    const bool lInt = l.kind == NodeKind::IntLit, rInt = r.kind == NodeKind::IntLit;
+    const bool lNum = lInt || l.kind == NodeKind::RealLit, rNum = rInt || r.kind == NodeKind::RealLit;
+    if (lInt && rInt) return compare(intValue(l), intValue(r));
+    if (lNum && rNum) {
+        const double x = lInt ? static_cast<double>(intValue(l)) : realValue(l);
+        const double y = rInt ? static_cast<double>(intValue(r)) : realValue(r);
+        return compare(x, y);
+    }
+    if (l.kind == NodeKind::BoolLit && r.kind == NodeKind::BoolLit && (op == TokId::EqEq || op == TokId::NotEq))
+        return compare(l.op == TokId::True, r.op == TokId::True);
+    return std::nullopt;   // the compiler reports anything else
+}
+
+NodeId Folder::expr(NodeId e) {
+    const NodeKind kind = at(e).kind;
+    if (kind == NodeKind::Neg) {
+        const NodeId x = expr(at(e).a);
+        at(e).a = x;
+        AstNode& v = at(x);
+        AstNode& n = at(e);
+        if (v.kind == NodeKind::IntLit) {
+            n.kind = NodeKind::IntLit;
+            setIntValue(n, static_cast<std::int64_t>(0 - static_cast<std::uint64_t>(intValue(v))));
+        } else if (v.kind == NodeKind::RealLit) {
+            n.kind = NodeKind::RealLit;
+            setRealValue(n, -realValue(v));
+        } else if (v.kind == NodeKind::Neg && typeOf(v.a) != Ty::Unknown && typeOf(v.a) != Ty::Boolean) {
+            return v.a;   // - - x
+        }
+        return e;
+    }
+    if (kind != NodeKind::Binary) return e;
+
+    { const NodeId l = expr(at(e).a); at(e).a = l; }
+    { const NodeId r = expr(at(e).b); at(e).b = r; }
+    AstNode& n = at(e);
+    const AstNode& l = at(n.a);
+    const AstNode& r = at(n.b);
+    const bool lInt = l.kind == NodeKind::IntLit, rInt = r.kind == NodeKind::IntLit;
+    const bool lNum = lInt || l.kind == NodeKind::RealLit, rNum = rInt || r.kind == NodeKind::RealLit;
+
+    if (lInt && rInt) {
+        const auto x = static_cast<std::uint64_t>(intValue(l)), y = static_cast<std::uint64_t>(intValue(r));
+        std::uint64_t v;
+        switch (n.op) {
+            case TokId::Plus:  v = x + y; break;
+            case TokId::Minus: v = x - y; break;
+            case TokId::Star:  v = x * y; break;
+            default:
+                if (y == 0) return e;   // the VM's "integer division by zero"
+                v = intValue(r) == -1 ? 0 - x : static_cast<std::uint64_t>(intValue(l) / intValue(r));
+                break;
+        }
+        n.kind = NodeKind::IntLit;
+        setIntValue(n, static_cast<std::int64_t>(v));
+        return e;
+    }
+    if (lNum && rNum) {
+        const double x = lInt ? static_cast<double>(intValue(l)) : realValue(l);
+        const double y = rInt ? static_cast<double>(intValue(r)) : realValue(r);
+        double v;
+        switch (n.op) {
+            case TokId::Plus:  v = x + y; break;
+            case TokId::Minus: v = x - y; break;
+            case TokId::Star:  v = x * y; break;
+            default:           v = x / y; break;
+        }
+        n.kind = NodeKind::RealLit;
+        setRealValue(n, v);
+        return e;
+    }
+
+    // identities: the literal is 0 / 1 and the result keeps x's type
+    // (not -0.0: x - -0.0 is x + 0.0, which turns -0.0 into +0.0)
+    auto is = [](const AstNode& k, std::int64_t v) {
+        return (k.kind == NodeKind::IntLit && intValue(k) == v) ||
+               (k.kind == NodeKind::RealLit && realValue(k) == static_cast<double>(v) && !std::signbit(realValue(k)));
+    };
+    auto keeps = [&](NodeId x, const AstNode& k) {
+        const Ty t = typeOf(x);
+        return t == Ty::Integer ? k.kind == NodeKind::IntLit : t == Ty::Real;
+    };
+    const NodeId a = n.a, b = n.b;
+    switch (n.op) {
+        case TokId::Star:
+            if (is(r, 1) && keeps(a, r)) return a;
+            if (is(l, 1) && keeps(b, l)) return b;
+            break;
+        case TokId::Slash:
+            if (is(r, 1) && keeps(a, r)) return a;
+            break;
+        case TokId::Minus:
+            if (is(r, 0) && keeps(a, r)) return a;
+            break;
+        case TokId::Plus:
+            if (is(r, 0) && typeOf(a) == Ty::Integer && rInt) return a;
+            if (is(l, 0) && typeOf(b) == Ty::Integer && lInt) return b;
+            break;
+        default:
+            break;
+    }
+    return e;
+}
+
+} // namespace
+
+FoldStats foldConstants(ParseResult& ast) {
+    FoldStats stats;
+    if (!ast.root || ast[ast.root].kind != NodeKind::Program) return stats;
+    stats.before = countList(ast, ast.root);
+    Folder(ast).program();
+
+    ParseResult compact;
+    compact.nodes.reserve(stats.before + 1);
+    ast.root = copyList(ast, compact, ast.root);
+    ast.nodes = std::move(compact.nodes);   // the names stay where they are
+    stats.after = ast.nodeCount();
+    return stats;
+}
@@ -0,0 +1,27 @@
+// Fold.h
+// Optional AST pass between the parse and the compiler (Compiler.h):
+//   - arithmetic on integer / real literals becomes one literal (integers
+//     wrap as in the VM; an integer division by zero is left for run time)
+//   - x * 1, 1 * x, x / 1, x - 0, and for integers x + 0 / 0 + x, become x
+//     (typed by the declarations; -0.0 + 0 is +0.0, so reals keep their + 0)
+//   - a condition on two literals picks its branch: the other one is dropped,
+//     as is a while loop that never runs
+// Calls are never dropped (they can print), and no conversion is: x * 1.0
+// only folds when x is real.
+//
+// Dropped branches are not type-checked again, so compile the tree first and
+// fold only a program that compiles; then compile the folded tree with the
+// first module's result types (compileProgram(ast, &checked)). That way -O
+// accepts the same programs, with the same types, as a plain compile.
+// The tree is compacted afterwards, so the node count is what it costs.
+#pragma once
+#include <cstddef>
+#include "Ast.h"
+
+struct FoldStats {
+    size_t before = 0, after = 0;   // nodes reachable from the root
+    size_t removed() const { return before - after; }
+};
+
+// in place; `ast` must be a StartSymbol::Program tree
+FoldStats foldConstants(ParseResult& ast);
@@ -0,0 +1,105 @@
+// Grammar.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+enum class Rule {
+    // Top-level
+    Rat25F, OptFuncDefs, FuncDefs, FuncDefsPrime, Function,
+    OptParamList, ParamList, ParamListPrime, Parameter, Qualifier,
+    Body, OptDeclList, DeclList, DeclListPrime, Declaration, IDs, IDsPrime,
+    // Statements
+    StatementList, StatementListPrime, Statement, Compound, Assign, If, OptElse,
+    Return, Print, Scan, While,
+    // Expressions
+    Condition, Relop, Expression, ExpressionPrime, Term, TermPrime, Factor, Primary, PrimaryPrime
+};
+inline constexpr size_t kRuleCount = static_cast<size_t>(Rule::PrimaryPrime) + 1;
+
+// Every production alternative the parser can print: X(id, rule, text).
+// <Relop> is printed with the operator lexeme and has no fixed entry.
+#define RAT25F_PRODUCTIONS(X) \
+    X(Rat25F,            Rat25F,             "<Rat25F> -> <Opt Function Definitions> <Opt Declaration List> <Statement List>") \
+    X(OptFuncDefs,       OptFuncDefs,        "<Opt Function Definitions> -> <Function Definitions>") \
+    X(OptFuncDefsEps,    OptFuncDefs,        "<Opt Function Definitions> -> ε") \
+    X(FuncDefs,          FuncDefs,           "<Function Definitions> -> <Function> <Function Definitions Prime>") \
+    X(FuncDefsPrime,     FuncDefsPrime,      "<Function Definitions Prime> -> <Function> <Function Definitions Prime>") \
+    X(FuncDefsPrimeEps,  FuncDefsPrime,      "<Function Definitions Prime> -> ε") \
+    X(Function,          Function,           "<Function> -> function <Identifier> ( <Opt Parameter List> ) <Opt Declaration List> <Body>") \
+    X(OptParamList,      OptParamList,       "<Opt Parameter List> -> <Parameter List>") \
+    X(OptParamListEps,   OptParamList,       "<Opt Parameter List> -> ε") \
+    X(ParamList,         ParamList,          "<Parameter List> -> <Parameter> <Parameter List Prime>") \
+    X(ParamListPrime,    ParamListPrime,     "<Parameter List Prime> -> , <Parameter> <Parameter List Prime>") \
+    X(ParamListPrimeEps, ParamListPrime,     "<Parameter List Prime> -> ε") \
+    X(Parameter,         Parameter,          "<Parameter> -> <IDs> <Qualifier>") \
+    X(Qualifier,         Qualifier,          "<Qualifier> -> integer | boolean | real") \
+    X(Body,              Body,               "<Body> -> { <Opt Statement List> }") \
+    X(OptDeclList,       OptDeclList,        "<Opt Declaration List> -> <Declaration List>") \
+    X(OptDeclListEps,    OptDeclList,        "<Opt Declaration List> -> ε") \
+    X(DeclList,          DeclList,           "<Declaration List> -> <Declaration> ; <Declaration List Prime>") \
+    X(DeclListPrime,     DeclListPrime,      "<Declaration List Prime> -> <Declaration> ; <Declaration List Prime>") \
+    X(DeclListPrimeEps,  DeclListPrime,      "<Declaration List Prime> -> ε") \
+    X(Declaration,       Declaration,        "<Declaration> -> <Qualifier> <IDs>") \
+    X(IDs,               IDs,                "<IDs> -> <Identifier> <IDs Prime>") \
+    X(IDsPrime,          IDsPrime,           "<IDs Prime> -> , <IDs>") \
+    X(IDsPrimeEps,       IDsPrime,           "<IDs Prime> -> ε") \
+    X(StatementList,     StatementList,      "<Statement List> -> <Statement> <Statement List Prime>") \
+    X(StatementListEps,  StatementList,      "<Statement List> -> ε") \
+    X(StmtListPrime,     StatementListPrime, "<Statement List Prime> -> <Statement> <Statement List Prime>") \
+    X(StmtListPrimeEps,  StatementListPrime, "<Statement List Prime> -> ε") \
+    X(StmtCompound,      Statement,          "<Statement> -> <Compound>") \
+    X(StmtAssign,        Statement,          "<Statement> -> <Assign>") \
+    X(StmtIf,            Statement,          "<Statement> -> <If>") \
+    X(StmtReturn,        Statement,          "<Statement> -> <Return>") \
+    X(StmtPrint,         Statement,          "<Statement> -> <Print>") \
+    X(StmtScan,          Statement,          "<Statement> -> <Scan>") \
+    X(StmtWhile,         Statement,          "<Statement> -> <While>") \
+    X(StmtEps,           Statement,          "<Statement> -> ε") \
+    X(Compound,          Compound,           "<Compound> -> { <Statement List> }") \
+    X(Assign,            Assign,             "<Assign> -> <Identifier> = <Expression> ;") \
+    X(If,                If,                 "<If> -> if ( <Condition> ) <Statement> <OptElse> fi") \
+    X(OptElse,           OptElse,            "<OptElse> -> else <Statement>") \
+    X(OptElseEps,        OptElse,            "<OptElse> -> ε") \
+    X(Return,            Return,             "<Return> -> return ; | return <Expression> ;") \
+    X(Print,             Print,              "<Print> -> put ( <Expression> ) ;") \
+    X(Scan,              Scan,               "<Scan> -> get ( <IDs> ) ;") \
+    X(While,             While,              "<While> -> while ( <Condition> ) <Statement>") \
+    X(Condition,         Condition,          "<Condition> -> <Expression> <Relop> <Expression>") \
+    X(Expression,        Expression,         "<Expression> -> <Term> <Expression Prime>") \
+    X(ExprPrimePlus,     ExpressionPrime,    "<Expression Prime> -> + <Term> <Expression Prime>") \
+    X(ExprPrimeMinus,    ExpressionPrime,    "<Expression Prime> -> - <Term> <Expression Prime>") \
+    X(ExprPrimeEps,      ExpressionPrime,    "<Expression Prime> -> ε") \
+    X(Term,              Term,               "<Term> -> <Factor> <Term Prime>") \
+    X(TermPrimeStar,     TermPrime,          "<Term Prime> -> * <Factor> <Term Prime>") \
+    X(TermPrimeSlash,    TermPrime,          "<Term Prime> -> / <Factor> <Term Prime>") \
+    X(TermPrimeEps,      TermPrime,          "<Term Prime> -> ε") \
+    X(FactorNeg,         Factor,             "<Factor> -> - <Primary>") \
+    X(Factor,            Factor,             "<Factor> -> <Primary>") \
+    X(PrimaryId,         Primary,            "<Primary> -> <Identifier> <Primary Prime>") \
+    X(PrimaryInt,        Primary,            "<Primary> -> <Integer>") \
+    X(PrimaryReal,       Primary,            "<Primary> -> <Real>") \
+    X(PrimaryParen,      Primary,            "<Primary> -> ( <Expression> )") \
+    X(PrimaryBool,       Primary,            "<Primary> -> true | false") \
+    X(PrimaryString,     Primary,            "<Primary> -> <String>") \
+    X(PrimaryPrimeCall,  PrimaryPrime,       "<Primary Prime> -> ( <IDs> )") \
+    X(PrimaryPrimeEps,   PrimaryPrime,       "<Primary Prime> -> ε")
+
+enum class Prod : std::uint8_t {
+#define RAT25F_PROD_ENUM(id, rule, text) id,
+    RAT25F_PRODUCTIONS(RAT25F_PROD_ENUM)
+#undef RAT25F_PROD_ENUM
+};
+
+struct ProdInfo {
+    Rule rule;
+    const char* text;
+};
+
+inline constexpr ProdInfo kProdInfo[] = {
+#define RAT25F_PROD_INFO(id, rule, text) { Rule::rule, text },
+    RAT25F_PRODUCTIONS(RAT25F_PROD_INFO)
+#undef RAT25F_PROD_INFO
+};
+inline constexpr size_t kProdCount = sizeof(kProdInfo) / sizeof(kProdInfo[0]);
+
+constexpr const ProdInfo& prodInfo(Prod p) { return kProdInfo[static_cast<size_t>(p)]; }
@@ -0,0 +1,231 @@
+#include "Incremental.h"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include "Lexer.h"
+#include "WorkerPool.h"
+
+// FNV-1a over the span bytes; the tail is seeded apart from functions
+static std::uint64_t spanKey(std::string_view text, bool tail) {
+    std::uint64_t h = tail ? 0x84222325cbf29ce4ull : 0xcbf29ce484222325ull;
+    for (unsigned char c : text) { h ^= c; h *= 0x100000001b3ull; }
+    return h ^ text.size();
+}
+
+static std::uint64_t positionKey(std::uint64_t key, size_t line, size_t col) {
+    std::uint64_t h = key;
+    for (std::uint64_t v : { static_cast<std::uint64_t>(line), static_cast<std::uint64_t>(col) })
+        h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    return h;
+}
+
+static size_t commonPrefix(std::string_view a, std::string_view b) {
+    const size_t n = std::min(a.size(), b.size());
+    constexpr size_t kBlock = 4096;
+    size_t i = 0;
+    while (i + kBlock <= n && std::memcmp(a.data() + i, b.data() + i, kBlock) == 0) i += kBlock;
+    while (i < n && a[i] == b[i]) ++i;
+    return i;
+}
+
+// common suffix, at most `limit` bytes (so it can't overlap the prefix)
+static size_t commonSuffix(std::string_view a, std::string_view b, size_t limit) {
+    constexpr size_t kBlock = 4096;
+    const char* ea = a.data() + a.size();
+    const char* eb = b.data() + b.size();
+    size_t i = 0;
+    while (i + kBlock <= limit && std::memcmp(ea - i - kBlock, eb - i - kBlock, kBlock) == 0) i += kBlock;
+    while (i < limit && ea[-1 - static_cast<std::ptrdiff_t>(i)] == eb[-1 - static_cast<std::ptrdiff_t>(i)]) ++i;
+    return i;
+}
+
+IncrementalParser::IncrementalParser(TraceConfig trace, ParserPolicy policy)
+    : trace_(std::move(trace)), policy_(std::move(policy)) {}
+
+void IncrementalParser::clear() {
+    cache_.clear();
+    prev_.clear();
+    prevSpans_ = {};
+    prevKeys_.clear();
+    havePrev_ = false;
+}
+
+void IncrementalParser::collect(const SpanResult& r) {
+    // re-apply the cap across spans, as one Parser would
+    for (const Diagnostic& d : r.diags) {
+        if (diags_.size() < policy_.maxDiagnostics) diags_.push_back(d);
+        else ++dropped_;
+    }
+    dropped_ += r.dropped;
+}
+
+bool IncrementalParser::fullParse(std::string_view src, ProductionSink& sink) {
+    havePrev_ = false;   // the cached spans stay valid for their text
+    stats_ = {};
+    auto mem = std::make_shared<MemorySink>();
+    bool ok = true;
+    try {
+        Lexer lex(src);
+        Parser<FullTrace> parser(lex, trace_, policy_, mem);
+        parser.parse(StartSymbol::Program);
+        diags_ = parser.diagnostics();
+        dropped_ = parser.droppedDiagnostics();
+    } catch (const std::exception& e) {
+        error_ = e.what();
+        ok = false;
+    }
+    sink.write(mem->str());
+    return ok;
+}
+
+// Boundaries of src from the previous version's: spans wholly before the
+// first changed byte keep their offsets, and the scan restarts at the span
+// the edit begins in. Once it reaches an old boundary (shifted by the size
+// change) inside the unchanged suffix, the rest are the old spans shifted.
+// keys gets the known content key per span, 0 where it must be hashed.
+// False if the edit is before the first function; the caller rescans all.
+bool IncrementalParser::respan(std::string_view src, FunctionSpans& spans,
+                               std::vector<std::uint64_t>& keys) {
+    const std::string_view old = prev_;
+    const FunctionSpans& os = prevSpans_;
+    const size_t n = os.starts.size();
+    const size_t prefix = commonPrefix(old, src);
+    const size_t suffix = commonSuffix(old, src, std::min(old.size(), src.size()) - prefix);
+    const std::ptrdiff_t delta = static_cast<std::ptrdiff_t>(src.size()) - static_cast<std::ptrdiff_t>(old.size());
+    auto shifted = [&](size_t off) { return static_cast<size_t>(static_cast<std::ptrdiff_t>(off) + delta); };
+    auto oldEnd = [&](size_t i) { return i + 1 < n ? os.starts[i + 1] : os.tail; };
+
+    if (prefix == old.size() && prefix == src.size()) {   // unchanged
+        spans = os;
+        keys = prevKeys_;
+        return true;
+    }
+    if (n == 0 || prefix < os.starts[0]) return false;
+
+    // first span whose text (or the boundary right after it) may have changed
+    size_t a = 0;
+    while (a + 1 < n && oldEnd(a) < prefix) ++a;
+
+    spans.starts.assign(os.starts.begin(), os.starts.begin() + a);
+    keys.assign(prevKeys_.begin(), prevKeys_.begin() + a);
+
+    // skip the old boundaries inside the edit; signed, as one the edit deleted
+    // along with more than the text before it lands below 0. shifted() is
+    // only ever used on the boundaries past them.
+    const auto newChangeEnd = static_cast<std::ptrdiff_t>(src.size() - suffix);
+    size_t j = a + 1;   // next old boundary that could be a resync point
+    while (j < n && static_cast<std::ptrdiff_t>(os.starts[j]) + delta < newChangeEnd) ++j;
+
+    FunctionSpans part;
+    for (size_t from = os.starts[a];;) {
+        const size_t until = j < n ? shifted(os.starts[j]) : static_cast<size_t>(-1);
+        const bool ok = findFunctionSpans(src, part, from, until);
+        stats_.rescanned += (part.tail ? part.tail : part.starts.empty() ? from : part.starts.back()) - from;
+        if (!ok) return false;
+        if (part.tail) {   // ran into the tail: no old boundary lined up
+            spans.starts.insert(spans.starts.end(), part.starts.begin(), part.starts.end());
+            keys.resize(spans.starts.size() + 1, 0);
+            spans.tail = part.tail;
+            return true;
+        }
+        const size_t x = part.starts.back();   // first function at or past `until`
+        spans.starts.insert(spans.starts.end(), part.starts.begin(), part.starts.end() - 1);
+        while (j < n && shifted(os.starts[j]) < x) ++j;
+        if (j < n && shifted(os.starts[j]) == x) {
+            // resynced: old spans j.. and the tail are unchanged text
+            keys.resize(spans.starts.size(), 0);
+            for (size_t k = j; k < n; ++k) spans.starts.push_back(shifted(os.starts[k]));
+            keys.insert(keys.end(), prevKeys_.begin() + static_cast<std::ptrdiff_t>(j), prevKeys_.end());
+            spans.tail = shifted(os.tail);
+            return true;
+        }
+        from = x;
+    }
+}
+
+bool IncrementalParser::update(std::string_view src, ProductionSink& sink, unsigned threads) {
+    error_.clear();
+    diags_.clear();
+    dropped_ = 0;
+    stats_ = {};
+    if (policy_.semanticChecks) return fullParse(src, sink);
+
+    FunctionSpans spans;
+    std::vector<std::uint64_t> keys;
+    if (!havePrev_ || !respan(src, spans, keys)) {
+        if (!findFunctionSpans(src, spans)) return fullParse(src, sink);
+        keys.assign(spans.starts.size() + 1, 0);
+        stats_.rescanned = src.size();
+    }
+
+    const size_t n = spans.starts.size();
+    struct Span { size_t begin, end; std::uint64_t key, slot; bool hit; };
+    std::vector<Span> list(n + 1);
+    for (size_t i = 0; i <= n; ++i) {
+        Span& s = list[i];
+        s.begin = i < n ? spans.starts[i] : spans.tail;
+        s.end = i + 1 < n ? spans.starts[i + 1] : i < n ? spans.tail : src.size();
+        s.key = keys[i] ? keys[i] : spanKey(src.substr(s.begin, s.end - s.begin), i == n);
+        s.slot = s.key;
+        s.hit = cache_.count(s.key) != 0;
+    }
+
+    // start positions, only where they matter: spans to parse, and cached
+    // spans with diagnostics (reusable only where they were parsed)
+    std::vector<std::pair<size_t, size_t>> pos(n + 1);
+    SourceCursor cursor(src);
+    for (size_t i = 0; i <= n; ++i) {
+        Span& s = list[i];
+        if (s.hit) continue;
+        cursor.seek(s.begin);
+        pos[i] = { cursor.line, cursor.col };
+        const std::uint64_t pk = positionKey(s.key, cursor.line, cursor.col);
+        if (cache_.count(pk)) { s.slot = pk; s.hit = true; }
+    }
+
+    // parse the misses (in parallel when asked)
+    std::vector<size_t> todo;
+    for (size_t i = 0; i <= n; ++i) if (!list[i].hit) todo.push_back(i);
+    std::vector<SpanResult> fresh(todo.size());
+    parallelFor(todo.size(), threads, [&](size_t k) {
+        const Span& s = list[todo[k]];
+        const auto [line, col] = pos[todo[k]];
+        parseSpan(src, s.begin, s.end, line, col, todo[k] == n, trace_, policy_, fresh[k]);
+    });
+    // a span that threw may not match a serial parse (error text, or a span
+    // the boundary scan got wrong), nor may an inexact one; reproduce it exactly
+    for (const SpanResult& r : fresh) if (!r.ok || !r.exact) return fullParse(src, sink);
+
+    // new cache = exactly the spans of this version; hits move over without a copy
+    std::unordered_map<std::uint64_t, SpanResult> next;
+    next.reserve(n + 1);
+    for (const Span& s : list)
+        if (s.hit && !next.count(s.slot)) next.insert(cache_.extract(s.slot));
+    for (size_t k = 0; k < todo.size(); ++k) {
+        Span& s = list[todo[k]];
+        if (!fresh[k].diags.empty()) s.slot = positionKey(s.key, pos[todo[k]].first, pos[todo[k]].second);
+        next.insert_or_assign(s.slot, std::move(fresh[k]));
+    }
+    cache_ = std::move(next);
+
+    std::vector<std::string_view> texts;
+    texts.reserve(n + 1);
+    for (const Span& s : list) {
+        const SpanResult& r = cache_.at(s.slot);
+        texts.emplace_back(r.text);
+        collect(r);
+    }
+    writeProgram(trace_, texts, sink);
+
+    prev_.assign(src.data(), src.size());
+    prevSpans_ = std::move(spans);
+    prevKeys_.resize(n + 1);
+    for (size_t i = 0; i <= n; ++i) prevKeys_[i] = list[i].key;
+    havePrev_ = true;
+
+    stats_.spans = n + 1;
+    stats_.reparsed = todo.size();
+    stats_.reused = n + 1 - todo.size();
+    return true;
+}
@@ -0,0 +1,67 @@
+// Incremental.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "parser.h"
+#include "Sink.h"
+#include "SplitParse.h"
+
+// Reparse a program after edits, e.g. on every save in an editor. The
+// program is split into top-level spans (each <Function>, then the tail) by
+// the same boundary scan as -p, and each span's trace text/diagnostics are
+// cached under a hash of its content. update() diffs the new source against
+// the previous one, rescans boundaries only around the edit, and reparses
+// only spans it has no cached result for, so the work scales with the edit.
+// The output equals a full serial parse of the same source.
+//
+// A span's trace has no positions in it, so a clean span is reused even if
+// edits above moved it; a span with diagnostics is reused only at the same
+// start line/col. Semantic checks need the whole program, so with
+// policy.semanticChecks every update is a full parse.
+class IncrementalParser {
+public:
+    IncrementalParser(TraceConfig trace, ParserPolicy policy);
+
+    // Parse src, writing the trace to sink. False if the parse failed; the
+    // error is then in error() and sink has the trace up to it.
+    bool update(std::string_view src, ProductionSink& sink, unsigned threads = 1);
+
+    const std::string& error() const { return error_; }
+    const DiagnosticList& diagnostics() const { return diags_; }
+    size_t droppedDiagnostics() const { return dropped_; }
+
+    struct Stats {
+        size_t spans = 0;      // functions + tail of the last update (0 = full parse)
+        size_t rescanned = 0;  // bytes the boundary scan lexed
+        size_t reparsed = 0;
+        size_t reused = 0;
+    };
+    const Stats& stats() const { return stats_; }
+    void clear();
+
+private:
+    bool fullParse(std::string_view src, ProductionSink& sink);
+    bool respan(std::string_view src, FunctionSpans& spans, std::vector<std::uint64_t>& keys);
+    void collect(const SpanResult& r);
+
+    TraceConfig trace_;
+    ParserPolicy policy_;
+    // clean spans under their content key, spans with diagnostics under the
+    // content key mixed with their start position
+    std::unordered_map<std::uint64_t, SpanResult> cache_;
+
+    // the previous version, to diff against
+    std::string prev_;
+    FunctionSpans prevSpans_;
+    std::vector<std::uint64_t> prevKeys_;   // content key per span (tail last)
+    bool havePrev_ = false;
+
+    std::string error_;
+    DiagnosticList diags_;
+    size_t dropped_ = 0;
+    Stats stats_;
+};
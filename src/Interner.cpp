@@ -0,0 +1,55 @@
+#include "Interner.h"
+
+std::uint32_t Interner::hash(std::string_view s) {
+    // FNV-1a
+    std::uint32_t h = 2166136261u;
+    for (unsigned char c : s) { h ^= c; h *= 16777619u; }
+    return h;
+}
+
+Interner::Id Interner::find(std::string_view s) const {
+    if (slots_.empty()) return kNone;
+    const size_t mask = slots_.size() - 1;
+    const std::uint32_t h = hash(s);
+    for (size_t i = h & mask;; i = (i + 1) & mask) {
+        Id id = slots_[i];
+        if (id == kNone) return kNone;
+        if (hashes_[id] == h && name(id) == s) return id;
+    }
+}
+
+Interner::Id Interner::intern(std::string_view s) {
+    if ((size() + 1) * 2 > slots_.size()) grow();   // load factor <= 1/2
+    const size_t mask = slots_.size() - 1;
+    const std::uint32_t h = hash(s);
+    size_t i = h & mask;
+    for (;; i = (i + 1) & mask) {
+        Id id = slots_[i];
+        if (id == kNone) break;
+        if (hashes_[id] == h && name(id) == s) return id;
+    }
+    const Id id = static_cast<Id>(size());
+    slots_[i] = id;
+    hashes_.push_back(h);
+    chars_.append(s.data(), s.size());
+    starts_.push_back(static_cast<std::uint32_t>(chars_.size()));
+    return id;
+}
+
+void Interner::grow() {
+    size_t cap = slots_.empty() ? 256 : slots_.size() * 2;
+    slots_.assign(cap, kNone);
+    const size_t mask = cap - 1;
+    for (Id id = 0; id < size(); ++id) {
+        size_t i = hashes_[id] & mask;
+        while (slots_[i] != kNone) i = (i + 1) & mask;
+        slots_[i] = id;
+    }
+}
+
+void Interner::clear() {
+    if (!slots_.empty()) slots_.assign(slots_.size(), kNone);
+    hashes_.clear();
+    starts_.assign(1, 0);
+    chars_.clear();
+}
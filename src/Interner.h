@@ -0,0 +1,33 @@
+// Interner.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Maps identifier spellings to dense 32-bit IDs (0, 1, 2, ... in first-seen
+// order). One open-addressing table with linear probing; the characters
+// live in a single pool, so interning never allocates per name.
+class Interner {
+public:
+    using Id = std::uint32_t;
+    static constexpr Id kNone = 0xFFFFFFFFu;
+
+    Id intern(std::string_view s);
+    Id find(std::string_view s) const;   // kNone if never interned
+    std::string_view name(Id id) const {
+        return { chars_.data() + starts_[id], starts_[id + 1] - starts_[id] };
+    }
+    size_t size() const { return hashes_.size(); }
+    void clear();                        // keeps capacity
+
+private:
+    static std::uint32_t hash(std::string_view s);
+    void grow();
+
+    std::vector<Id> slots_;              // kNone = empty, else an Id
+    std::vector<std::uint32_t> hashes_;  // per Id, for rehashing
+    std::vector<std::uint32_t> starts_{0};  // Id -> offset in chars_ (plus end sentinel)
+    std::string chars_;
+};
@@ -0,0 +1,75 @@
+// Keywords.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include "Token.h"
+
+namespace kw_detail {
+constexpr char fold(char c) { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c | 0x20) : c; }
+
+// s matches lowercase keyword k (same length) ignoring ASCII case
+constexpr bool eqFold(std::string_view s, std::string_view k) {
+    for (size_t i = 0; i < k.size(); ++i)
+        if (fold(s[i]) != k[i]) return false;
+    return true;
+}
+} // namespace kw_detail
+
+// Case-insensitive keyword lookup: switch on length, then first char, then
+// one folded compare. No copies, no hashing. Also tags the soft keywords
+// true/false, which stay Identifiers (see isReservedKeyword).
+constexpr TokId lookupKeyword(std::string_view s) {
+    using kw_detail::eqFold;
+    if (s.empty()) return TokId::None;
+    const char c = kw_detail::fold(s[0]);
+    TokId k = TokId::None;
+    std::string_view text;
+    switch (s.size()) {
+        case 2:
+            if (c == 'i')      { k = TokId::If;        text = "if"; }
+            else if (c == 'f') { k = TokId::Fi;        text = "fi"; }
+            break;
+        case 3:
+            if (c == 'i')      { k = TokId::Int;       text = "int"; }
+            else if (c == 'g') { k = TokId::Get;       text = "get"; }
+            else if (c == 'p') { k = TokId::Put;       text = "put"; }
+            break;
+        case 4:
+            if (c == 'r')      { k = TokId::Real;      text = "real"; }
+            else if (c == 'e') { k = TokId::Else;      text = "else"; }
+            else if (c == 't') { k = TokId::True;      text = "true"; }
+            break;
+        case 5:
+            if (c == 'w')      { k = TokId::While;     text = "while"; }
+            else if (c == 'f') { k = TokId::False;     text = "false"; }
+            break;
+        case 6:
+            if (c == 'r')      { k = TokId::Return;    text = "return"; }
+            break;
+        case 7:
+            if (c == 'i')      { k = TokId::Integer;   text = "integer"; }
+            else if (c == 'b') { k = TokId::Boolean;   text = "boolean"; }
+            break;
+        case 8:
+            if (c == 'f')      { k = TokId::Function;  text = "function"; }
+            break;
+        default:
+            break;
+    }
+    return (k != TokId::None && eqFold(s, text)) ? k : TokId::None;
+}
+
+// true/false get an ID but are still lexed as identifiers
+constexpr bool isReservedKeyword(TokId id) {
+    return id != TokId::None && id != TokId::True && id != TokId::False;
+}
+
+static_assert(lookupKeyword("while") == TokId::While);
+static_assert(lookupKeyword("WhIlE") == TokId::While);
+static_assert(lookupKeyword("function") == TokId::Function);
+static_assert(lookupKeyword("boolean") == TokId::Boolean);
+static_assert(lookupKeyword("FALSE") == TokId::False && !isReservedKeyword(TokId::False));
+static_assert(lookupKeyword("fun") == TokId::None);
+static_assert(lookupKeyword("reals") == TokId::None);
+static_assert(lookupKeyword("retürn") == TokId::None);
@@ -0,0 +1,309 @@
+// LL1Grammar.h
+// The Rat25F grammar as data for the table-driven LL1Parser: every
+// alternative with the production it prints, then FIRST / FOLLOW sets and
+// the LL(1) parse table, all computed at compile time from that list.
+//
+// The grammar is written the way the recursive-descent Parser behaves:
+//  - banner strings before the top-level parts and between functions /
+//    statements are a silent <Banners> nonterminal (skipBannerStrings)
+//  - list "Prime" rules are the right-recursive forms the parse loops trace
+//  - a nonterminal without an error message takes its last alternative
+//    on any token nothing else claims, like the parser's final `else`, so
+//    errors surface at the same token with the same message
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include "Diagnostic.h"
+#include "Grammar.h"
+#include "Token.h"
+
+// ----- terminals -----
+// keyword / operator / separator tokens are their TokId, the rest their type
+enum : unsigned {
+    kTermIdent = static_cast<unsigned>(TokId::Count),
+    kTermIntLit, kTermRealLit, kTermString, kTermEof, kTermOther,
+    kTermCount
+};
+static_assert(kTermCount <= 64, "terminal sets are 64-bit masks");
+
+constexpr unsigned termOf(const Token& t) {
+    switch (t.type) {
+        case TokenType::Identifier: return kTermIdent;
+        case TokenType::Integer:    return kTermIntLit;
+        case TokenType::Real:       return kTermRealLit;
+        case TokenType::String:     return kTermString;
+        case TokenType::EndOfFile:  return kTermEof;
+        case TokenType::Keyword:
+        case TokenType::Operator:
+        case TokenType::Separator:  return t.id == TokId::None ? kTermOther : static_cast<unsigned>(t.id);
+        default:                    return kTermOther;
+    }
+}
+constexpr std::uint64_t termBit(unsigned t) { return std::uint64_t{1} << t; }
+
+// ----- nonterminals -----
+// the parser's Rules, plus <Banners> and the tail of <Return>
+enum class LLNt : std::uint8_t {
+    Rat25F, Banners, OptFuncDefs, FuncDefs, FuncDefsPrime, Function,
+    OptParamList, ParamList, ParamListPrime, Parameter, Qualifier, Body,
+    OptDeclList, DeclList, DeclListPrime, Declaration, IDs, IDsPrime,
+    StatementList, StatementListPrime, Statement, Compound, Assign, If, OptElse,
+    Return, ReturnTail, Print, Scan, While,
+    Condition, Relop, Expression, ExpressionPrime, Term, TermPrime, Factor, Primary, PrimaryPrime,
+    Count
+};
+inline constexpr size_t kLLNtCount = static_cast<size_t>(LLNt::Count);
+
+// empty: the last alternative is the default
+inline constexpr std::optional<DiagCode> kLLNtError[kLLNtCount] = {
+    {}, {}, {}, {}, {}, {},
+    {}, {}, {}, {}, DiagCode::ExpectedQualifier, {},
+    {}, {}, {}, {}, {}, {},
+    {}, {}, DiagCode::ExpectedStatement, {}, {}, {}, {},
+    {}, {}, {}, {}, {},
+    {}, DiagCode::ExpectedRelop, {}, {}, {}, {}, {}, DiagCode::ExpectedPrimary, {},
+};
+
+// ----- alternatives -----
+struct LLSym {
+    enum Kind : std::uint8_t { Term, Skip, Nt };   // Skip: matched, not echoed
+    Kind kind;
+    std::uint8_t index;
+};
+constexpr LLSym llT(TokId id)     { return { LLSym::Term, static_cast<std::uint8_t>(id) }; }
+constexpr LLSym llT(unsigned t)   { return { LLSym::Term, static_cast<std::uint8_t>(t) }; }
+constexpr LLSym llSkip(unsigned t) { return { LLSym::Skip, static_cast<std::uint8_t>(t) }; }
+constexpr LLSym llN(LLNt n)       { return { LLSym::Nt, static_cast<std::uint8_t>(n) }; }
+
+// what expanding an alternative prints: its Prod, nothing, or "<Relop> -> op"
+enum class LLEmit : std::uint8_t { Prod, Silent, Relop };
+
+inline constexpr size_t kLLMaxRhs = 7;
+
+struct LLAlt {
+    LLNt lhs;
+    LLEmit emit;
+    Prod prod;
+    std::uint8_t size;
+    std::array<LLSym, kLLMaxRhs> rhs;
+};
+
+constexpr LLAlt llAlt(LLNt lhs, LLEmit emit, Prod prod, std::initializer_list<LLSym> rhs) {
+    LLAlt a{ lhs, emit, prod, static_cast<std::uint8_t>(rhs.size()), {} };
+    size_t i = 0;
+    for (LLSym s : rhs) a.rhs[i++] = s;
+    return a;
+}
+constexpr LLAlt llAlt(LLNt lhs, Prod prod, std::initializer_list<LLSym> rhs) {
+    return llAlt(lhs, LLEmit::Prod, prod, rhs);
+}
+constexpr LLAlt llSilent(LLNt lhs, std::initializer_list<LLSym> rhs) {
+    return llAlt(lhs, LLEmit::Silent, Prod::Rat25F, rhs);
+}
+constexpr LLAlt llRelop(TokId op) { return llAlt(LLNt::Relop, LLEmit::Relop, Prod::Condition, { llT(op) }); }
+
+// Alternatives of one nonterminal are contiguous, in the order the parser
+// tries them: where two could claim a token the earlier one keeps it.
+inline constexpr LLAlt kLLAlts[] = {
+    llAlt(LLNt::Rat25F, Prod::Rat25F, { llN(LLNt::Banners), llN(LLNt::OptFuncDefs), llN(LLNt::Banners),
+                                        llN(LLNt::OptDeclList), llN(LLNt::Banners), llN(LLNt::StatementList) }),
+    llSilent(LLNt::Banners, { llSkip(kTermString), llN(LLNt::Banners) }),
+    llSilent(LLNt::Banners, {}),
+
+    // ----- function defs -----
+    llAlt(LLNt::OptFuncDefs, Prod::OptFuncDefs, { llN(LLNt::FuncDefs) }),
+    llAlt(LLNt::OptFuncDefs, Prod::OptFuncDefsEps, {}),
+    llAlt(LLNt::FuncDefs, Prod::FuncDefs, { llN(LLNt::Function), llN(LLNt::Banners), llN(LLNt::FuncDefsPrime) }),
+    llAlt(LLNt::FuncDefsPrime, Prod::FuncDefsPrime, { llN(LLNt::Function), llN(LLNt::Banners), llN(LLNt::FuncDefsPrime) }),
+    llAlt(LLNt::FuncDefsPrime, Prod::FuncDefsPrimeEps, {}),
+    llAlt(LLNt::Function, Prod::Function, { llT(TokId::Function), llT(kTermIdent), llT(TokId::LParen),
+                                            llN(LLNt::OptParamList), llT(TokId::RParen),
+                                            llN(LLNt::OptDeclList), llN(LLNt::Body) }),
+    llAlt(LLNt::OptParamList, Prod::OptParamList, { llN(LLNt::ParamList) }),
+    llAlt(LLNt::OptParamList, Prod::OptParamListEps, {}),
+    llAlt(LLNt::ParamList, Prod::ParamList, { llN(LLNt::Parameter), llN(LLNt::ParamListPrime) }),
+    llAlt(LLNt::ParamListPrime, Prod::ParamListPrime, { llT(TokId::Comma), llN(LLNt::Parameter), llN(LLNt::ParamListPrime) }),
+    llAlt(LLNt::ParamListPrime, Prod::ParamListPrimeEps, {}),
+    llAlt(LLNt::Parameter, Prod::Parameter, { llN(LLNt::IDs), llN(LLNt::Qualifier) }),
+    llAlt(LLNt::Qualifier, Prod::Qualifier, { llT(TokId::Integer) }),
+    llAlt(LLNt::Qualifier, Prod::Qualifier, { llT(TokId::Boolean) }),
+    llAlt(LLNt::Qualifier, Prod::Qualifier, { llT(TokId::Real) }),
+    // <Opt Statement List> traces exactly like <Statement List>
+    llAlt(LLNt::Body, Prod::Body, { llT(TokId::LBrace), llN(LLNt::Banners), llN(LLNt::StatementList), llT(TokId::RBrace) }),
+
+    // ----- declarations -----
+    llAlt(LLNt::OptDeclList, Prod::OptDeclList, { llN(LLNt::DeclList) }),
+    llAlt(LLNt::OptDeclList, Prod::OptDeclListEps, {}),
+    llAlt(LLNt::DeclList, Prod::DeclList, { llN(LLNt::Declaration), llT(TokId::Semicolon), llN(LLNt::DeclListPrime) }),
+    llAlt(LLNt::DeclListPrime, Prod::DeclListPrime, { llN(LLNt::Declaration), llT(TokId::Semicolon), llN(LLNt::DeclListPrime) }),
+    llAlt(LLNt::DeclListPrime, Prod::DeclListPrimeEps, {}),
+    llAlt(LLNt::Declaration, Prod::Declaration, { llN(LLNt::Qualifier), llN(LLNt::IDs) }),
+    llAlt(LLNt::IDs, Prod::IDs, { llT(kTermIdent), llN(LLNt::IDsPrime) }),
+    llAlt(LLNt::IDsPrime, Prod::IDsPrime, { llT(TokId::Comma), llN(LLNt::IDs) }),
+    llAlt(LLNt::IDsPrime, Prod::IDsPrimeEps, {}),
+
+    // ----- statements -----
+    llAlt(LLNt::StatementList, Prod::StatementList, { llN(LLNt::Statement), llN(LLNt::Banners), llN(LLNt::StatementListPrime) }),
+    llAlt(LLNt::StatementList, Prod::StatementListEps, {}),
+    llAlt(LLNt::StatementListPrime, Prod::StmtListPrime, { llN(LLNt::Statement), llN(LLNt::Banners), llN(LLNt::StatementListPrime) }),
+    llAlt(LLNt::StatementListPrime, Prod::StmtListPrimeEps, {}),
+    llAlt(LLNt::Statement, Prod::StmtEps, { llSkip(kTermString) }),   // a banner where a statement goes
+    llAlt(LLNt::Statement, Prod::StmtCompound, { llN(LLNt::Compound) }),
+    llAlt(LLNt::Statement, Prod::StmtAssign, { llN(LLNt::Assign) }),
+    llAlt(LLNt::Statement, Prod::StmtIf, { llN(LLNt::If) }),
+    llAlt(LLNt::Statement, Prod::StmtReturn, { llN(LLNt::Return) }),
+    llAlt(LLNt::Statement, Prod::StmtPrint, { llN(LLNt::Print) }),
+    llAlt(LLNt::Statement, Prod::StmtScan, { llN(LLNt::Scan) }),
+    llAlt(LLNt::Statement, Prod::StmtWhile, { llN(LLNt::While) }),
+    llAlt(LLNt::Compound, Prod::Compound, { llT(TokId::LBrace), llN(LLNt::Banners), llN(LLNt::StatementList), llT(TokId::RBrace) }),
+    llAlt(LLNt::Assign, Prod::Assign, { llT(kTermIdent), llT(TokId::Assign), llN(LLNt::Expression), llT(TokId::Semicolon) }),
+    llAlt(LLNt::If, Prod::If, { llT(TokId::If), llT(TokId::LParen), llN(LLNt::Condition), llT(TokId::RParen),
+                                llN(LLNt::Statement), llN(LLNt::OptElse), llT(TokId::Fi) }),
+    llAlt(LLNt::OptElse, Prod::OptElse, { llT(TokId::Else), llN(LLNt::Statement) }),
+    llAlt(LLNt::OptElse, Prod::OptElseEps, {}),
+    llAlt(LLNt::Return, Prod::Return, { llT(TokId::Return), llN(LLNt::ReturnTail) }),
+    llSilent(LLNt::ReturnTail, { llT(TokId::Semicolon) }),
+    llSilent(LLNt::ReturnTail, { llN(LLNt::Expression), llT(TokId::Semicolon) }),
+    llAlt(LLNt::Print, Prod::Print, { llT(TokId::Put), llT(TokId::LParen), llN(LLNt::Expression),
+                                      llT(TokId::RParen), llT(TokId::Semicolon) }),
+    llAlt(LLNt::Scan, Prod::Scan, { llT(TokId::Get), llT(TokId::LParen), llN(LLNt::IDs),
+                                    llT(TokId::RParen), llT(TokId::Semicolon) }),
+    llAlt(LLNt::While, Prod::While, { llT(TokId::While), llT(TokId::LParen), llN(LLNt::Condition),
+                                      llT(TokId::RParen), llN(LLNt::Statement) }),
+
+    // ----- expressions -----
+    llAlt(LLNt::Condition, Prod::Condition, { llN(LLNt::Expression), llN(LLNt::Relop), llN(LLNt::Expression) }),
+    llRelop(TokId::EqEq), llRelop(TokId::NotEq), llRelop(TokId::Greater),
+    llRelop(TokId::Less), llRelop(TokId::LessEq), llRelop(TokId::GreaterEq),
+    llAlt(LLNt::Expression, Prod::Expression, { llN(LLNt::Term), llN(LLNt::ExpressionPrime) }),
+    llAlt(LLNt::ExpressionPrime, Prod::ExprPrimePlus, { llT(TokId::Plus), llN(LLNt::Term), llN(LLNt::ExpressionPrime) }),
+    llAlt(LLNt::ExpressionPrime, Prod::ExprPrimeMinus, { llT(TokId::Minus), llN(LLNt::Term), llN(LLNt::ExpressionPrime) }),
+    llAlt(LLNt::ExpressionPrime, Prod::ExprPrimeEps, {}),
+    llAlt(LLNt::Term, Prod::Term, { llN(LLNt::Factor), llN(LLNt::TermPrime) }),
+    llAlt(LLNt::TermPrime, Prod::TermPrimeStar, { llT(TokId::Star), llN(LLNt::Factor), llN(LLNt::TermPrime) }),
+    llAlt(LLNt::TermPrime, Prod::TermPrimeSlash, { llT(TokId::Slash), llN(LLNt::Factor), llN(LLNt::TermPrime) }),
+    llAlt(LLNt::TermPrime, Prod::TermPrimeEps, {}),
+    llAlt(LLNt::Factor, Prod::FactorNeg, { llT(TokId::Minus), llN(LLNt::Primary) }),
+    llAlt(LLNt::Factor, Prod::Factor, { llN(LLNt::Primary) }),
+    llAlt(LLNt::Primary, Prod::PrimaryId, { llT(kTermIdent), llN(LLNt::PrimaryPrime) }),
+    llAlt(LLNt::Primary, Prod::PrimaryInt, { llT(kTermIntLit) }),
+    llAlt(LLNt::Primary, Prod::PrimaryReal, { llT(kTermRealLit) }),
+    llAlt(LLNt::Primary, Prod::PrimaryParen, { llT(TokId::LParen), llN(LLNt::Expression), llT(TokId::RParen) }),
+    llAlt(LLNt::Primary, Prod::PrimaryBool, { llT(TokId::True) }),    // only keyword-typed true/false;
+    llAlt(LLNt::Primary, Prod::PrimaryBool, { llT(TokId::False) }),   // the Lexer's are identifiers
+    llAlt(LLNt::Primary, Prod::PrimaryString, { llT(kTermString) }),  // ParserPolicy::allowStringPrimary
+    llAlt(LLNt::PrimaryPrime, Prod::PrimaryPrimeCall, { llT(TokId::LParen), llN(LLNt::IDs), llT(TokId::RParen) }),
+    llAlt(LLNt::PrimaryPrime, Prod::PrimaryPrimeEps, {}),
+};
+inline constexpr size_t kLLAltCount = sizeof(kLLAlts) / sizeof(kLLAlts[0]);
+static_assert(kLLAltCount < 255, "table entries are one byte");
+
+// ----- FIRST / FOLLOW / table -----
+inline constexpr std::uint8_t kLLNoAlt = 0xFF;
+
+struct LL1Tables {
+    std::array<std::uint8_t, kLLNtCount> begin{}, end{};     // alternatives [begin, end)
+    std::array<bool, kLLNtCount> nullable{};
+    std::array<std::uint64_t, kLLNtCount> first{}, follow{};
+    std::array<std::uint64_t, kLLNtCount> conflicts{};       // tokens two alternatives claim
+    std::array<std::array<std::uint8_t, kTermCount>, kLLNtCount> table{};
+    bool contiguous = true;
+};
+
+// FIRST of rhs[from..]; `nullable` tells whether all of it can be empty
+constexpr std::uint64_t llFirstOf(const LL1Tables& g, const LLAlt& a, size_t from, bool& nullable) {
+    std::uint64_t set = 0;
+    for (size_t i = from; i < a.size; ++i) {
+        const LLSym s = a.rhs[i];
+        if (s.kind != LLSym::Nt) { nullable = false; return set | termBit(s.index); }
+        set |= g.first[s.index];
+        if (!g.nullable[s.index]) { nullable = false; return set; }
+    }
+    nullable = true;
+    return set;
+}
+
+constexpr LL1Tables buildLL1Tables() {
+    LL1Tables g;
+    for (size_t n = 0; n < kLLNtCount; ++n) g.begin[n] = g.end[n] = 0;
+    for (size_t p = 0; p < kLLAltCount; ++p) {
+        const size_t n = static_cast<size_t>(kLLAlts[p].lhs);
+        if (g.end[n] == 0) g.begin[n] = static_cast<std::uint8_t>(p);
+        else if (g.end[n] != p) g.contiguous = false;
+        g.end[n] = static_cast<std::uint8_t>(p + 1);
+    }
+
+    // nullable + FIRST, to a fixed point
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (const LLAlt& a : kLLAlts) {
+            const size_t n = static_cast<size_t>(a.lhs);
+            bool empty = false;
+            const std::uint64_t f = g.first[n] | llFirstOf(g, a, 0, empty);
+            if (f != g.first[n] || (empty && !g.nullable[n])) changed = true;
+            g.first[n] = f;
+            g.nullable[n] = g.nullable[n] || empty;
+        }
+    }
+
+    // FOLLOW; every StartSymbol may be followed by end of input
+    g.follow[static_cast<size_t>(LLNt::Rat25F)] |= termBit(kTermEof);
+    g.follow[static_cast<size_t>(LLNt::Statement)] |= termBit(kTermEof);
+    g.follow[static_cast<size_t>(LLNt::Expression)] |= termBit(kTermEof);
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (const LLAlt& a : kLLAlts) {
+            for (size_t i = 0; i < a.size; ++i) {
+                if (a.rhs[i].kind != LLSym::Nt) continue;
+                bool restEmpty = false;
+                std::uint64_t f = llFirstOf(g, a, i + 1, restEmpty);
+                if (restEmpty) f |= g.follow[static_cast<size_t>(a.lhs)];
+                std::uint64_t& dst = g.follow[a.rhs[i].index];
+                if ((dst | f) != dst) { dst |= f; changed = true; }
+            }
+        }
+    }
+
+    // table[A][t]: FIRST of each alternative (+ FOLLOW(A) when it can be
+    // empty), first claim wins; the rest goes to the default alternative
+    for (size_t n = 0; n < kLLNtCount; ++n) {
+        for (auto& e : g.table[n]) e = kLLNoAlt;
+        for (size_t p = g.begin[n]; p < g.end[n]; ++p) {
+            bool empty = false;
+            std::uint64_t set = llFirstOf(g, kLLAlts[p], 0, empty);
+            if (empty) set |= g.follow[n];
+            for (unsigned t = 0; t < kTermCount; ++t) {
+                if (!(set & termBit(t))) continue;
+                if (g.table[n][t] == kLLNoAlt) g.table[n][t] = static_cast<std::uint8_t>(p);
+                else g.conflicts[n] |= termBit(t);
+            }
+        }
+        if (kLLNtError[n] || g.end[n] == 0) continue;
+        for (auto& e : g.table[n])
+            if (e == kLLNoAlt) e = static_cast<std::uint8_t>(g.end[n] - 1);
+    }
+    return g;
+}
+
+inline constexpr LL1Tables kLL1 = buildLL1Tables();
+
+static_assert(kLL1.contiguous, "alternatives of a nonterminal must be listed together");
+constexpr bool llEveryNtHasAlternatives() {
+    for (size_t n = 0; n < kLLNtCount; ++n)
+        if (kLL1.end[n] == 0) return false;
+    return true;
+}
+static_assert(llEveryNtHasAlternatives(), "a nonterminal has no alternatives");
+// LL(1) apart from one known spot: <Banners> may be followed by a <Statement>
+// that starts with a string; the banner reading keeps it, as in the Parser
+constexpr bool llOnlyBannerConflict() {
+    for (size_t n = 0; n < kLLNtCount; ++n) {
+        const std::uint64_t allowed = n == static_cast<size_t>(LLNt::Banners) ? termBit(kTermString) : 0;
+        if (kLL1.conflicts[n] & ~allowed) return false;
+    }
+    return true;
+}
+static_assert(llOnlyBannerConflict(), "grammar is not LL(1)");
@@ -0,0 +1,102 @@
+// LL1Parser.cpp
+#include "LL1Parser.h"
+
+template <class TracePolicy>
+LL1Parser<TracePolicy>::LL1Parser(TokenSource& lex, const TraceConfig& trace, ParserPolicy policy,
+                                  std::shared_ptr<ProductionSink> sink)
+    : lex_(lex), filter_(trace), policy_(std::move(policy)), sink_(std::move(sink)) {
+    stack_.reserve(256);
+    tok_ = lex_.nextToken();
+    term_ = termOf(tok_);
+}
+
+template <class TracePolicy>
+void LL1Parser<TracePolicy>::advance() {
+    tok_ = lex_.nextToken();
+    term_ = termOf(tok_);
+}
+
+template <class TracePolicy>
+bool LL1Parser<TracePolicy>::matches(unsigned term) const {
+    if (term_ == term) return true;
+    // lenient: an Identifier carrying the keyword's ID also counts
+    return policy_.lenientKeywords && term_ == kTermIdent && term < kTermIdent
+        && tok_.id == static_cast<TokId>(term);
+}
+
+template <class TracePolicy>
+unsigned LL1Parser<TracePolicy>::lookup(LLNt nt) const {
+    const auto& row = kLL1.table[static_cast<size_t>(nt)];
+    unsigned p = row[term_];
+    if (p == kLLNoAlt && policy_.lenientKeywords && term_ == kTermIdent && tok_.id != TokId::None)
+        p = row[static_cast<unsigned>(tok_.id)];
+    if (p != kLLNoAlt && kLLAlts[p].prod == Prod::PrimaryString && !policy_.allowStringPrimary)
+        return kLLNoAlt;
+    return p;
+}
+
+template <class TracePolicy>
+void LL1Parser<TracePolicy>::expand(const LLAlt& alt) {
+    if constexpr (TracePolicy::kTrace) {
+        if (alt.emit == LLEmit::Prod) {
+            if (filter_.show[static_cast<size_t>(alt.prod)]) sink_->production(alt.prod);
+        } else if (alt.emit == LLEmit::Relop && filter_.relop) {
+            sink_->relop(tok_);
+        }
+    }
+    for (size_t i = alt.size; i-- > 0;) stack_.push_back(alt.rhs[i]);
+    if (stack_.size() > maxDepth_) maxDepth_ = stack_.size();
+}
+
+template <class TracePolicy>
+void LL1Parser<TracePolicy>::parse(StartSymbol start) {
+    stack_.clear();
+    maxDepth_ = 0;
+    switch (start) {
+        case StartSymbol::Program:    stack_.push_back(llN(LLNt::Rat25F)); break;
+        case StartSymbol::Statement:  stack_.push_back(llN(LLNt::Statement)); break;
+        case StartSymbol::Expression: stack_.push_back(llN(LLNt::Expression)); break;
+    }
+    // like Parser, done once the start symbol is; trailing tokens are left
+    while (!stack_.empty()) {
+        const LLSym s = stack_.back();
+        stack_.pop_back();
+        if (s.kind == LLSym::Nt) {
+            const LLNt nt = static_cast<LLNt>(s.index);
+            const unsigned p = lookup(nt);
+            if (p == kLLNoAlt) errorHere(*kLLNtError[s.index]);
+            expand(kLLAlts[p]);
+            continue;
+        }
+        if (!matches(s.index)) errorExpecting(s.index);
+        if constexpr (TracePolicy::kEcho) {
+            if (s.kind == LLSym::Term && policy_.echoTokens && tok_.type != TokenType::EndOfFile)
+                sink_->token(tok_);
+        }
+        advance();
+    }
+}
+
+// ------------ errors ------------
+// the codes Parser's expect*() use
+template <class TracePolicy>
+[[noreturn]] void LL1Parser<TracePolicy>::errorExpecting(unsigned term) const {
+    if (term == kTermIdent) errorHere(DiagCode::ExpectedIdentifier);
+    // literals only ever start the <Primary> alternative the lookup picked
+    if (term > kTermIdent) errorHere(DiagCode::ExpectedPrimary);
+    const TokId id = static_cast<TokId>(term);
+    if (id < TokId::Assign) errorHere(DiagCode::ExpectedKeyword, id);
+    if (id < TokId::LParen) errorHere(DiagCode::ExpectedOperator, id);
+    errorHere(DiagCode::ExpectedSeparator, id);
+}
+
+template <class TracePolicy>
+[[noreturn]] void LL1Parser<TracePolicy>::errorHere(DiagCode code, TokId expected) const {
+    const TokenPos pos = lex_.position(tok_);
+    ParseError e({ code, expected, pos.line, pos.col, 0, 0, tok_.lexeme });
+    e.settle();   // always leaves the parse
+    throw e;
+}
+
+template class LL1Parser<FullTrace>;
+template class LL1Parser<NoTrace>;
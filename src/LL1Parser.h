@@ -0,0 +1,54 @@
+// LL1Parser.h
+// Table-driven alternative to the recursive-descent Parser: an explicit
+// symbol stack and kLL1.table (LL1Grammar.h) lookups on (nonterminal,
+// token), so nesting depth is bounded by memory rather than the C++ stack.
+// Prints the same tokens and productions as Parser for every StartSymbol,
+// and fails at the same token with the same message.
+//
+// Trace only: no AST, semantic checks or recovery (ParserPolicy's
+// semanticChecks / recover / maxNesting are ignored). A keyword spelled as
+// an identifier (lenientKeywords) is taken as the keyword only where an
+// identifier can't go.
+#pragma once
+#include <memory>
+#include <vector>
+#include "Diagnostic.h"
+#include "LL1Grammar.h"
+#include "Sink.h"
+#include "Token.h"
+#include "TokenSource.h"
+#include "parser.h"
+
+template <class TracePolicy = FullTrace>
+class LL1Parser {
+public:
+    LL1Parser(TokenSource& lex,
+              const TraceConfig& trace = {},
+              ParserPolicy policy = {},
+              std::shared_ptr<ProductionSink> sink = std::make_shared<ConsoleSink>());
+
+    void parse(StartSymbol start = StartSymbol::Program);
+
+    // deepest the symbol stack got in the last parse
+    size_t maxStackDepth() const { return maxDepth_; }
+
+private:
+    void advance();
+    bool matches(unsigned term) const;
+    unsigned lookup(LLNt nt) const;   // alternative index, kLLNoAlt on an error
+    void expand(const LLAlt& alt);
+    [[noreturn]] void errorHere(DiagCode code, TokId expected = TokId::None) const;
+    [[noreturn]] void errorExpecting(unsigned term) const;   // a terminal that did not match
+
+    TokenSource& lex_;
+    Token tok_{};
+    unsigned term_ = kTermEof;   // termOf(tok_)
+    TraceFilter filter_;
+    ParserPolicy policy_;
+    std::shared_ptr<ProductionSink> sink_;
+    std::vector<LLSym> stack_;   // kept between parses
+    size_t maxDepth_ = 0;
+};
+
+extern template class LL1Parser<FullTrace>;
+extern template class LL1Parser<NoTrace>;
@@ -1,153 +1,193 @@
 #include "Lexer.h"
-#include <cctype>
-#include <algorithm>
-#include <unordered_set>
-#include <vector>
+#include "Keywords.h"
+#include "Utf8.h"
+#include <iterator>
 
-Lexer::Lexer(std::istream& input) : in(input) { advance(); }
+Lexer::Lexer(std::istream& input)
+    : owned_(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()) {
+    start(owned_);
+}
+
+Lexer::Lexer(std::string_view source) { start(source); }
+
+Lexer::Lexer(std::string_view source, size_t startLine, size_t startCol) {
+    start(source);
+    line = startLine;
+    col = startCol;
+}
+
+void Lexer::reset(std::istream& input) {
+    owned_.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    reset(std::string_view(owned_));
+}
+
+void Lexer::reset(std::string_view source) {
+    eof = false;
+    line = 1;
+    col = 0;
+    tokLine_ = 1;
+    tokCol_ = 0;
+    start(source);
+}
+
+void Lexer::reset(std::string_view source, size_t startLine, size_t startCol) {
+    reset(source);
+    line = startLine;
+    col = startCol;
+}
 
-void Lexer::advance() {
-    int ch = in.get();
-    if (ch == EOF) { eof = true; current = '\0'; return; }
-    current = static_cast<char>(ch);
+// position on the first character (same state the old stream advance() produced)
+void Lexer::start(std::string_view source) {
+    begin_ = p_ = source.data();
+    end_ = source.data() + source.size();
+    ascii_ = scan::asciiEnd(p_, end_) == end_;
+    if (p_ == end_) { eof = true; current = '\0'; return; }
+    current = *p_;
     if (current == '\n') { line++; col = 0; } else { col++; }
 }
 
+TokenPos Lexer::position(const Token& t) const {
+    if (ascii_) return { t.line, t.col };
+    return utf8::tokenPosition(begin_, end_, t);
+}
+
 void Lexer::skipSpace() {
-    while (!eof && std::isspace(static_cast<unsigned char>(current))) {
-        advance();
-    }
+    if (eof || !hasClass(current, cc::Space)) return;
+    advanceRun(scan::spaceRun(p_ + 1, end_));
+}
+
+void Lexer::advanceRun(const scan::SpaceRun& run) {
+    // same line/col as advancing byte by byte: the last byte that becomes
+    // `current` is run.end (or the final byte if the input ends inside the run)
+    const char* last = (run.end < end_) ? run.end : end_ - 1;
+    if (run.newlines) { line += run.newlines; col = static_cast<size_t>(last - run.lastNl); }
+    else              { col += static_cast<size_t>(last - p_); }
+    p_ = run.end;
+    if (p_ >= end_) { p_ = end_; eof = true; current = '\0'; return; }
+    current = *p_;
 }
 
 
 Token Lexer::scanString() {
     // current == '"'
-    std::string lex;
     advance(); // skip opening quote
-    while (!eof && current != '"') {
-        lex.push_back(current);
-        advance();
-    }
+    const char* from = p_;
+    if (!eof && current != '"') advanceRun(scan::quoteRun(p_ + 1, end_));
+    std::string_view lex = spanFrom(from);
     if (!eof) advance(); // skip closing quote
-    return { TokenType::String, lex, line, col };
+    return { TokenType::String, TokId::None, lex, tokLine_, tokCol_ };
 }
 
 
-// --------- keyword table (compare case-insensitively) ----------
-static bool isKeyword(const std::string& s) {
-    static const std::unordered_set<std::string> K = {
-        // include both per class notes and what you used in tests
-        "integer","int","real","if","else","fi","while","return","get","put"
-    };
-    std::string k = s;
-    std::transform(k.begin(), k.end(), k.begin(), [](unsigned char c){ return std::tolower(c); });
-    return K.count(k) != 0;
-}
-
 // ----------------------- FSM: Identifier -----------------------
 Token Lexer::scanIdentifierFSM() {
-    std::string lex;
-    // first must be letter
-    lex.push_back(current);
-    advance();
-    // rest: letters/digits/$
-    while (!eof && isIdentRest(current)) { lex.push_back(current); advance(); }
-    if (isKeyword(lex)) return { TokenType::Keyword, lex, line, col };
-    return { TokenType::Identifier, lex, line, col };
+    const char* from = p_;
+    // first must be letter; rest: letters/digits/$/_
+    advanceInLine(scan::identEnd(p_ + 1, end_));
+    std::string_view lex = spanFrom(from);
+    const TokId id = lookupKeyword(lex);
+    if (isReservedKeyword(id)) return { TokenType::Keyword, id, lex, tokLine_, tokCol_ };
+    return { TokenType::Identifier, id, lex, tokLine_, tokCol_ };
 }
 
 // ------------------------ FSM: Numbers -------------------------
 // Integer [0-9]+, Real [0-9]+.[0-9]+, and also .[0-9]+ (teacher allows)
 Token Lexer::scanNumberFSM() {
-    std::string lex;
+    const char* from = p_;
     // consume 1+ digits
-    while (!eof && std::isdigit(static_cast<unsigned char>(current))) {
-        lex.push_back(current);
-        advance();
-    }
+    advanceInLine(scan::digitEnd(p_ + 1, end_));
     // look for '.' followed by 1+ digits
-    if (!eof && current == '.' && std::isdigit(static_cast<unsigned char>(peek()))) {
-        lex.push_back(current);  // consume '.'
-        advance();
-        while (!eof && std::isdigit(static_cast<unsigned char>(current))) {
-            lex.push_back(current);
-            advance();
-        }
-        return { TokenType::Real, lex, line, col };
+    if (!eof && current == '.' && isDigit(peek())) {
+        advanceInLine(scan::digitEnd(p_ + 2, end_));  // '.' and the digits
+        return { TokenType::Real, TokId::None, spanFrom(from), tokLine_, tokCol_ };
     }
     // if '.' not followed by a digit, DO NOT eat it (123. is not a real per notes)
-    return { TokenType::Integer, lex, line, col };
+    return { TokenType::Integer, TokId::None, spanFrom(from), tokLine_, tokCol_ };
 }
 
 Token Lexer::scanRealStartingWithDot() {
     // we are at '.' and peek is a digit (e.g., .001)
-    std::string lex;
-    lex.push_back(current); // '.'
-    advance();
-    while (!eof && std::isdigit(static_cast<unsigned char>(current))) {
-        lex.push_back(current);
-        advance();
-    }
-    return { TokenType::Real, lex, line, col };
+    const char* from = p_;
+    advanceInLine(scan::digitEnd(p_ + 2, end_)); // '.' and the digits
+    return { TokenType::Real, TokId::None, spanFrom(from), tokLine_, tokCol_ };
 }
 
 // -------------------- Operators / Separators -------------------
-bool Lexer::isSeparator(char c) const {
-    static const std::unordered_set<char> S = { '(',')','{','}','[',']',',',';' };
-    return S.count(c) != 0;
-}
-bool Lexer::isOperatorStart(char c) const {
-    // include ! for '!=' and = < > + - * / as basics
-    static const std::unordered_set<char> O = { '+','-','*','/','=','<','>','!','&','|' };
-    return O.count(c) != 0;
-}
-
 Token Lexer::scanOpOrSep() {
-    // try multi-char ops first
-    char p = peek();
-    if ((current == '<' && p == '=') ||
-        (current == '>' && p == '=') ||
-        (current == '=' && p == '=') ||
-        (current == '!' && p == '=') ||
-        (current == '&' && p == '&') ||
-        (current == '|' && p == '|')) {
-        std::string op; op.push_back(current); op.push_back(p);
-        advance(); advance();
-        return { TokenType::Operator, op, line, col };
-    }
-    // single-char operator?
-    if (isOperatorStart(current) && !(current == '!' || current == '&' || current == '|')) {
-        char c = current; advance();
-        return { TokenType::Operator, std::string(1,c), line, col };
-    }
-    // separator?
-    if (isSeparator(current)) {
-        char c = current; advance();
-        return { TokenType::Separator, std::string(1,c), line, col };
+    const char* from = p_;
+    const char p = peek();
+    TokenType type = TokenType::Operator;
+    TokId id = TokId::None;
+    int len = 1;
+    switch (current) {
+        // two-char ops first: <= >= == != && ||
+        case '<': if (p == '=') { id = TokId::LessEq;    len = 2; } else id = TokId::Less;    break;
+        case '>': if (p == '=') { id = TokId::GreaterEq; len = 2; } else id = TokId::Greater; break;
+        case '=': if (p == '=') { id = TokId::EqEq;      len = 2; } else id = TokId::Assign;  break;
+        case '!': if (p == '=') { id = TokId::NotEq;     len = 2; } else id = TokId::Bang;    break;
+        case '&': if (p == '&') { id = TokId::AndAnd;    len = 2; } else id = TokId::Amp;     break;
+        case '|': if (p == '|') { id = TokId::OrOr;      len = 2; } else id = TokId::Pipe;    break;
+        case '+': id = TokId::Plus;  break;
+        case '-': id = TokId::Minus; break;
+        case '*': id = TokId::Star;  break;
+        case '/': id = TokId::Slash; break;
+        // separators
+        case '(': type = TokenType::Separator; id = TokId::LParen;    break;
+        case ')': type = TokenType::Separator; id = TokId::RParen;    break;
+        case '{': type = TokenType::Separator; id = TokId::LBrace;    break;
+        case '}': type = TokenType::Separator; id = TokId::RBrace;    break;
+        case '[': type = TokenType::Separator; id = TokId::LBracket;  break;
+        case ']': type = TokenType::Separator; id = TokId::RBracket;  break;
+        case ',': type = TokenType::Separator; id = TokId::Comma;     break;
+        case ';': type = TokenType::Separator; id = TokId::Semicolon; break;
+        // unknown fallback
+        default:  type = TokenType::Unknown; break;
     }
-    // lone '!' / '&' / '|' that didn't form an operator
-    if (current=='!' || current=='&' || current=='|') {
-        char c = current; advance();
-        return { TokenType::Operator, std::string(1,c), line, col }; // or Unknown if disallowed
-    }
-    // unknown fallback
-    char bad = current; advance();
-    return { TokenType::Unknown, std::string(1,bad), line, col };
+    advance();
+    if (len == 2) advance();
+    return { type, id, spanFrom(from), tokLine_, tokCol_ };
 }
 
 // --------------------------- Dispatcher ------------------------
+#ifdef RAT25F_PROFILE
+// counts every token per kind, times one in kLexSampleEvery
 Token Lexer::nextToken() {
-    skipSpace();
-    if (eof) return { TokenType::EndOfFile, "", line, col };
-
-    if (current == '"') return scanString();                    // <-- NEW
-    if (current == '.' && std::isdigit(static_cast<unsigned char>(peek())))
-        return scanRealStartingWithDot();
-    if (isLetter(current)) return scanIdentifierFSM();
-    if (std::isdigit(static_cast<unsigned char>(current))) return scanNumberFSM();
-    if (isSeparator(current) || isOperatorStart(current)) return scanOpOrSep();
-
-    char bad = current; advance();
-    return { TokenType::Unknown, std::string(1,bad), line, col };
+    if (++prof_->lexTick < kLexSampleEvery) {
+        Token t = scanToken();
+        prof_->counters.lexTokens[static_cast<size_t>(t.type)]++;
+        return t;
+    }
+    prof_->lexTick = 0;
+    const std::uint64_t t0 = profileClock();
+    Token t = scanToken();
+    const size_t k = static_cast<size_t>(t.type);
+    prof_->counters.lexTicks[k] += profileClock() - t0;
+    prof_->counters.lexSampled[k]++;
+    prof_->counters.lexTokens[k]++;
+    return t;
 }
 
+Token Lexer::scanToken() {
+#else
+Token Lexer::nextToken() {
+#endif
+    skipSpace();
+    // every token carries the position of its first byte
+    tokLine_ = static_cast<std::uint32_t>(line);
+    tokCol_ = static_cast<std::uint32_t>(col);
+    if (eof) return { TokenType::EndOfFile, TokId::None, {}, tokLine_, tokCol_ };
+
+    // classes are disjoint, so one table load picks the FSM
+    const std::uint8_t k = charClass(current);
+    if (k & cc::Letter) return scanIdentifierFSM();
+    if (k & cc::Digit)  return scanNumberFSM();
+    if (k & cc::Quote)  return scanString();
+    if ((k & cc::Dot) && isDigit(peek())) return scanRealStartingWithDot();
+    if (k & (cc::Separator | cc::OpStart)) return scanOpOrSep();
+
+    // a whole UTF-8 sequence is one Unknown token (its bytes hold no '\n')
+    const char* bad = p_;
+    const size_t n = utf8::sequenceLength(p_, end_);
+    if (n > 1) advanceInLine(p_ + n); else advance();
+    return { TokenType::Unknown, TokId::None, spanFrom(bad), tokLine_, tokCol_ };
+}
\ No newline at end of file
@@ -2,43 +2,83 @@
 #pragma once
 #include <istream>
 #include <string>
+#include <string_view>
+#include "CharClass.h"
+#include "CharScan.h"
+#include "Profile.h"
 #include "Token.h"
+#include "TokenSource.h"
 
-class Lexer {
+class Lexer final : public TokenSource {
 public:
+    // stream input (pipes): the whole stream is read up front
     explicit Lexer(std::istream& input);
-    Token nextToken();
+    // buffer input (mmap'ed files): caller keeps `source` alive
+    explicit Lexer(std::string_view source);
+    // a slice of a larger buffer: line/col are those of source[0] in the whole
+    Lexer(std::string_view source, size_t startLine, size_t startCol);
+    // start over on another input, as the matching constructor would; the
+    // stream buffer keeps its capacity (batch runs reuse one Lexer per thread)
+    void reset(std::istream& input);
+    void reset(std::string_view source);
+    void reset(std::string_view source, size_t startLine, size_t startCol);
+    Token nextToken() override;
+    // tokens carry byte columns; codepoint columns are worked out here, and
+    // only if the source is not pure ASCII (Utf8.h)
+    TokenPos position(const Token& t) const override;
 
 private:
-    std::istream& in;
+#ifdef RAT25F_PROFILE
+    Token scanToken();                        // nextToken() minus the counters
+    ThreadProfile* prof_ = &threadProfile();  // a Lexer is used on the thread that built it
+#endif
+    std::string owned_;          // backing store for the istream constructor
+    const char* begin_ = nullptr;
+    const char* p_   = nullptr;  // points at `current`
+    const char* end_ = nullptr;
+    bool   ascii_ = true;        // no byte >= 0x80: byte columns are codepoint columns
     char   current{};
     bool   eof = false;
-    size_t line = 1, col = 0;
+    size_t line = 1, col = 0;                    // of `current`
+    std::uint32_t tokLine_ = 1, tokCol_ = 0;     // start of the token being scanned
 
-    void advance();
-    char peek() const { return static_cast<char>(in.peek()); }
-
-    // identifier helpers (first must be letter; rest can be letter/digit/$)
-    static bool isLetter(char c) {
-        return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+    void start(std::string_view source);
+    void advance() {
+        if (p_ + 1 >= end_) { p_ = end_; eof = true; current = '\0'; return; }
+        current = *++p_;
+        if (current == '\n') { line++; col = 0; } else { col++; }
+    }
+    char peek() const { return (p_ + 1 < end_) ? p_[1] : '\0'; }
+    // bulk advance to q (q > p_); bytes strictly between p_ and q contain no '\n'
+    void advanceInLine(const char* q) {
+        if (q >= end_) { col += static_cast<size_t>((end_ - 1) - p_); p_ = end_; eof = true; current = '\0'; return; }
+        col += static_cast<size_t>(q - p_);
+        p_ = q;
+        current = *p_;
+        if (current == '\n') { line++; col = 0; }
     }
-    // add '_' support
-    static bool isIdentRest(char c) {
-        return isLetter(c) || std::isdigit(static_cast<unsigned char>(c)) || c == '$' || c == '_';
+    // bulk advance over a run from p_ + 1 (scan::spaceRun / quoteRun)
+    void advanceRun(const scan::SpaceRun& run);
+    // lexeme from `from` up to (not including) the current character
+    std::string_view spanFrom(const char* from) const {
+        return { from, static_cast<size_t>(p_ - from) };
     }
 
+    // identifier helpers (first must be letter; rest can be letter/digit/$/_)
+    static bool isLetter(char c)    { return hasClass(c, cc::Letter); }
+    static bool isDigit(char c)     { return hasClass(c, cc::Digit); }
+    static bool isIdentRest(char c) { return hasClass(c, cc::IdentRest); }
+
     // declare a string scanner
     void skipSpace();
 
     // FSMs
-    Token scanIdentifierFSM();     // [A-Za-z][A-Za-z0-9$]*
+    Token scanIdentifierFSM();     // [A-Za-z][A-Za-z0-9$_]*
     Token scanNumberFSM();         // Integer [0-9]+  or Real [0-9]+.[0-9]+
     Token scanRealStartingWithDot(); // .[0-9]+
     Token scanString();   // " ... "
 
 
     // operators / separators
-    bool  isSeparator(char c) const;
-    bool  isOperatorStart(char c) const;
     Token scanOpOrSep();
 };
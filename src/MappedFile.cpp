@@ -0,0 +1,51 @@
+#include "MappedFile.h"
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define RAT25F_HAVE_MMAP 1
+#endif
+
+MappedFile::~MappedFile() { close(); }
+
+bool MappedFile::open(const std::string& path) {
+    close();
+#ifdef RAT25F_HAVE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st{};
+    if (::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            ::madvise(p, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+            ::close(fd);
+            data_ = static_cast<const char*>(p);
+            size_ = static_cast<size_t>(st.st_size);
+            mapped_ = true;
+            return true;
+        }
+    }
+    ::close(fd);
+#endif
+    // fallback: plain read (empty file, pipe, or no mmap)
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    fallback_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    data_ = fallback_.data();
+    size_ = fallback_.size();
+    return true;
+}
+
+void MappedFile::close() {
+#ifdef RAT25F_HAVE_MMAP
+    if (mapped_) ::munmap(const_cast<char*>(data_), size_);
+#endif
+    mapped_ = false;
+    data_ = nullptr;
+    size_ = 0;
+    fallback_.clear();
+}
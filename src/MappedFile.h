@@ -0,0 +1,29 @@
+// MappedFile.h
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only view of a whole file. Regular files are mmap'ed; anything that
+// can't be mapped (empty files, FIFOs, platforms without mmap) falls back to
+// reading into an owned buffer so callers always get one contiguous span.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    std::string_view view() const { return { data_, size_ }; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::string fallback_;
+};
@@ -0,0 +1,72 @@
+#include "PipelinedLexer.h"
+#include <limits>
+#include "CharScan.h"
+#include "Lexer.h"
+#include "Utf8.h"
+
+PipelinedLexer::PipelinedLexer(std::string_view source)
+    : source_(source),
+      ascii_(scan::asciiEnd(source.data(), source.data() + source.size()) == source.data() + source.size()),
+      ring_(new Batch[kSlots]) {
+    thread_ = std::thread([this, source] { produce(source); });
+}
+
+PipelinedLexer::~PipelinedLexer() {
+    stop_.store(true, std::memory_order_relaxed);
+    // wait() only returns once the value moves; a producer blocked on a full
+    // ring wakes up, sees stop_ and leaves
+    tail_.store(std::numeric_limits<std::uint64_t>::max(), std::memory_order_release);
+    tail_.notify_one();
+    thread_.join();
+}
+
+TokenPos PipelinedLexer::position(const Token& t) const {
+    if (ascii_) return { t.line, t.col };
+    return utf8::tokenPosition(source_.data(), source_.data() + source_.size(), t);
+}
+
+// the Lexer is built here: it belongs to the thread that runs it (Profile.h)
+void PipelinedLexer::produce(std::string_view source) {
+    Lexer lex(source);
+    for (std::uint64_t h = 0;; ++h) {
+        for (std::uint64_t t = tail_.load(std::memory_order_acquire); h - t >= kSlots;
+             t = tail_.load(std::memory_order_acquire)) {
+            if (stop_.load(std::memory_order_relaxed)) return;
+            tail_.wait(t, std::memory_order_acquire);
+        }
+        if (stop_.load(std::memory_order_relaxed)) return;
+
+        Batch& b = ring_[h % kSlots];
+        size_t n = 0;
+        bool eof = false;
+        while (n < kBatch && !eof) {
+            b.tokens[n] = lex.nextToken();
+            eof = b.tokens[n++].type == TokenType::EndOfFile;
+        }
+        b.count = n;
+        head_.store(h + 1, std::memory_order_release);
+        head_.notify_one();
+        if (eof) return;
+    }
+}
+
+Token PipelinedLexer::nextBatch() {
+    if (cur_) {
+        cur_ = nullptr;
+        pos_ = count_ = 0;
+        tail_.store(taken_, std::memory_order_release);   // its slot is free again
+        tail_.notify_one();
+    }
+    if (done_) return last_;
+
+    for (std::uint64_t h = head_.load(std::memory_order_acquire); h == taken_;
+         h = head_.load(std::memory_order_acquire))
+        head_.wait(h, std::memory_order_acquire);
+    cur_ = &ring_[taken_++ % kSlots];
+    count_ = cur_->count;
+    if (cur_->tokens[count_ - 1].type == TokenType::EndOfFile) {
+        done_ = true;
+        last_ = cur_->tokens[count_ - 1];
+    }
+    return cur_->tokens[pos_++];
+}
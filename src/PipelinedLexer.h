@@ -0,0 +1,61 @@
+// PipelinedLexer.h
+// Token source that lexes on its own thread: the Lexer fills batches of
+// kBatch tokens into a single-producer / single-consumer ring of kSlots
+// batches, and nextToken() hands them out one by one. The two threads only
+// synchronize once per batch (two atomic counters, no locks); a full ring
+// blocks the producer, so at most kSlots batches are ever in flight.
+//
+// Destroying it mid-stream (e.g. the Parser threw) stops and joins the
+// lexer thread. The source must outlive it; lexemes view the source.
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <thread>
+#include "Token.h"
+#include "TokenSource.h"
+
+class PipelinedLexer final : public TokenSource {
+public:
+    static constexpr size_t kBatch = 256;
+    static constexpr size_t kSlots = 8;   // 8 x 256 Tokens = 64 KiB in flight
+
+    explicit PipelinedLexer(std::string_view source);
+    ~PipelinedLexer() override;
+    PipelinedLexer(const PipelinedLexer&) = delete;
+    PipelinedLexer& operator=(const PipelinedLexer&) = delete;
+
+    Token nextToken() override {
+        if (pos_ < count_) return cur_->tokens[pos_++];
+        return nextBatch();
+    }
+    TokenPos position(const Token& t) const override;   // as Lexer::position
+
+private:
+    struct Batch {
+        std::array<Token, kBatch> tokens;
+        size_t count = 0;   // the last batch ends with EndOfFile
+    };
+    void produce(std::string_view source);   // the lexer thread
+    Token nextBatch();                       // release the current batch, wait for the next
+
+    std::string_view source_;
+    bool ascii_ = true;
+    std::unique_ptr<Batch[]> ring_;
+    // batches published / released so far; slot = counter % kSlots
+    alignas(64) std::atomic<std::uint64_t> head_{0};
+    alignas(64) std::atomic<std::uint64_t> tail_{0};
+    std::atomic<bool> stop_{false};
+
+    // consumer side
+    const Batch* cur_ = nullptr;
+    size_t pos_ = 0, count_ = 0;
+    std::uint64_t taken_ = 0;                // batches taken from the ring
+    bool done_ = false;                      // the EndOfFile batch was taken
+    Token last_{ TokenType::EndOfFile, TokId::None, {}, 1, 0 };
+
+    std::thread thread_;                     // last: starts once the rest exists
+};
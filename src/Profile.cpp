@@ -0,0 +1,204 @@
+#include "Profile.h"
+#include <algorithm>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+static constexpr const char* kRuleNames[] = {
+    "Rat25F", "OptFuncDefs", "FuncDefs", "FuncDefsPrime", "Function",
+    "OptParamList", "ParamList", "ParamListPrime", "Parameter", "Qualifier",
+    "Body", "OptDeclList", "DeclList", "DeclListPrime", "Declaration", "IDs", "IDsPrime",
+    "StatementList", "StatementListPrime", "Statement", "Compound", "Assign", "If", "OptElse",
+    "Return", "Print", "Scan", "While",
+    "Condition", "Relop", "Expression", "ExpressionPrime", "Term", "TermPrime", "Factor", "Primary", "PrimaryPrime",
+};
+static_assert(sizeof(kRuleNames) / sizeof(kRuleNames[0]) == kRuleCount, "one name per Rule");
+
+template <size_t N>
+static void addArray(std::array<std::uint64_t, N>& a, const std::array<std::uint64_t, N>& b) {
+    for (size_t i = 0; i < N; ++i) a[i] += b[i];
+}
+template <size_t N>
+static void subArray(std::array<std::uint64_t, N>& a, const std::array<std::uint64_t, N>& b) {
+    for (size_t i = 0; i < N; ++i) a[i] -= b[i];
+}
+
+void ProfileCounters::add(const ProfileCounters& o) {
+    addArray(calls, o.calls);
+    addArray(tokens, o.tokens);
+    addArray(selfTicks, o.selfTicks);
+    addArray(totalTicks, o.totalTicks);
+    addArray(lexTokens, o.lexTokens);
+    addArray(lexSampled, o.lexSampled);
+    addArray(lexTicks, o.lexTicks);
+}
+
+ProfileCounters& ProfileCounters::operator-=(const ProfileCounters& o) {
+    subArray(calls, o.calls);
+    subArray(tokens, o.tokens);
+    subArray(selfTicks, o.selfTicks);
+    subArray(totalTicks, o.totalTicks);
+    subArray(lexTokens, o.lexTokens);
+    subArray(lexSampled, o.lexSampled);
+    subArray(lexTicks, o.lexTicks);
+    return *this;
+}
+
+// ----- per-thread sets -----
+#ifdef RAT25F_PROFILE
+namespace {
+// the lock is taken when a thread first profiles, when it exits and on snapshots
+struct Registry {
+    std::mutex mu;
+    std::vector<ThreadProfile*> live;
+    ProfileCounters retired;   // threads that already exited
+};
+Registry& registry() {
+    static Registry* r = new Registry;   // outlives every thread_local
+    return *r;
+}
+
+struct Holder {
+    ThreadProfile tp;
+    Holder() {
+        std::lock_guard<std::mutex> lock(registry().mu);
+        registry().live.push_back(&tp);
+    }
+    ~Holder() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mu);
+        r.retired.add(tp.counters);
+        r.live.erase(std::find(r.live.begin(), r.live.end(), &tp));
+    }
+};
+} // namespace
+
+ThreadProfile& threadProfile() {
+    thread_local Holder h;
+    return h.tp;
+}
+
+bool gProfileRuleTiming = false;
+
+void setProfileRuleTiming(bool on) { gProfileRuleTiming = on; }
+#else
+void setProfileRuleTiming(bool) {}
+#endif
+
+ProfileCounters profileSnapshot() {
+    ProfileCounters sum;
+#ifdef RAT25F_PROFILE
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    sum = r.retired;
+    for (const ThreadProfile* tp : r.live) sum.add(tp->counters);
+#endif
+    return sum;
+}
+
+// ----- report -----
+static std::uint64_t lexEstimate(const ProfileCounters& c, size_t k) {
+    if (!c.lexSampled[k]) return 0;
+    return static_cast<std::uint64_t>(static_cast<double>(c.lexTicks[k]) *
+                                      static_cast<double>(c.lexTokens[k]) /
+                                      static_cast<double>(c.lexSampled[k]));
+}
+
+static std::string jsonString(const std::string& s) {
+    std::string out = "\"";
+    for (char ch : s) {
+        if (ch == '"' || ch == '\\') { out += '\\'; out += ch; }
+        else if (static_cast<unsigned char>(ch) < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof buf, "\\u%04x", static_cast<unsigned>(ch));
+            out += buf;
+        } else out += ch;
+    }
+    return out + "\"";
+}
+
+std::string formatProfile(const ProfileCounters& c, bool json, const std::string& label) {
+    std::vector<size_t> rules;
+    std::uint64_t selfSum = 0;
+    for (size_t i = 0; i < kRuleCount; ++i) {
+        if (c.calls[i]) rules.push_back(i);
+        selfSum += c.selfTicks[i];
+    }
+    // busiest rules first: by self time when rules were timed, else by calls
+    const bool timed = selfSum != 0;
+    const auto& key = timed ? c.selfTicks : c.calls;
+    std::stable_sort(rules.begin(), rules.end(), [&](size_t a, size_t b) { return key[a] > key[b]; });
+
+    std::string out;
+    char line[160];
+    if (json) {
+        out += "{\"input\": " + jsonString(label) + ", \"lex_sample_every\": " +
+               std::to_string(kLexSampleEvery) + ", \"rule_timing\": " + (timed ? "true" : "false") +
+               ", \"rules\": [";
+        for (size_t n = 0; n < rules.size(); ++n) {
+            size_t i = rules[n];
+            std::snprintf(line, sizeof line,
+                          "%s{\"rule\": \"%s\", \"calls\": %llu, \"tokens\": %llu, "
+                          "\"self_ticks\": %llu, \"total_ticks\": %llu}",
+                          n ? ", " : "", kRuleNames[i],
+                          static_cast<unsigned long long>(c.calls[i]),
+                          static_cast<unsigned long long>(c.tokens[i]),
+                          static_cast<unsigned long long>(c.selfTicks[i]),
+                          static_cast<unsigned long long>(c.totalTicks[i]));
+            out += line;
+        }
+        out += "], \"lexer\": [";
+        bool first = true;
+        for (size_t k = 0; k < kTokenTypeCount; ++k) {
+            if (!c.lexTokens[k]) continue;
+            std::snprintf(line, sizeof line,
+                          "%s{\"kind\": \"%s\", \"tokens\": %llu, \"sampled\": %llu, \"est_ticks\": %llu}",
+                          first ? "" : ", ", prettyTokenKind(static_cast<TokenType>(k)),
+                          static_cast<unsigned long long>(c.lexTokens[k]),
+                          static_cast<unsigned long long>(c.lexSampled[k]),
+                          static_cast<unsigned long long>(lexEstimate(c, k)));
+            out += line;
+            first = false;
+        }
+        out += "]}\n";
+        return out;
+    }
+
+    out += "profile: " + label + "\n";
+    if (timed) std::snprintf(line, sizeof line, "%-20s %12s %12s %14s %7s %14s\n",
+                             "rule", "calls", "tokens", "self ticks", "self%", "total ticks");
+    else       std::snprintf(line, sizeof line, "%-20s %12s %12s  (rules not timed, see -T)\n",
+                             "rule", "calls", "tokens");
+    out += line;
+    for (size_t i : rules) {
+        if (!timed) {
+            std::snprintf(line, sizeof line, "%-20s %12llu %12llu\n", kRuleNames[i],
+                          static_cast<unsigned long long>(c.calls[i]),
+                          static_cast<unsigned long long>(c.tokens[i]));
+            out += line;
+            continue;
+        }
+        std::snprintf(line, sizeof line, "%-20s %12llu %12llu %14llu %6.1f%% %14llu\n",
+                      kRuleNames[i],
+                      static_cast<unsigned long long>(c.calls[i]),
+                      static_cast<unsigned long long>(c.tokens[i]),
+                      static_cast<unsigned long long>(c.selfTicks[i]),
+                      selfSum ? 100.0 * static_cast<double>(c.selfTicks[i]) / static_cast<double>(selfSum) : 0.0,
+                      static_cast<unsigned long long>(c.totalTicks[i]));
+        out += line;
+    }
+    std::snprintf(line, sizeof line, "%-20s %12s %14s %14s  (1 in %u tokens timed)\n",
+                  "token kind", "tokens", "est. ticks", "ticks/token", kLexSampleEvery);
+    out += line;
+    for (size_t k = 0; k < kTokenTypeCount; ++k) {
+        if (!c.lexTokens[k]) continue;
+        std::uint64_t est = lexEstimate(c, k);
+        std::snprintf(line, sizeof line, "%-20s %12llu %14llu %14.1f\n",
+                      prettyTokenKind(static_cast<TokenType>(k)),
+                      static_cast<unsigned long long>(c.lexTokens[k]),
+                      static_cast<unsigned long long>(est),
+                      static_cast<double>(est) / static_cast<double>(c.lexTokens[k]));
+        out += line;
+    }
+    return out;
+}
@@ -0,0 +1,134 @@
+// Profile.h
+// Per-rule / per-token-kind hot-path counters, compiled in with
+// -DRAT25F_PROFILE only. Without it the hooks below expand to nothing and
+// Parser / Lexer carry no extra members.
+//
+// Counters are plain arrays, one set per thread (no locks, no atomics on the
+// hot path). profileSnapshot() sums every thread's set, including threads
+// that have already exited; read it while no parse is running.
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "Grammar.h"
+#include "Token.h"
+
+#ifdef RAT25F_PROFILE
+#define RAT25F_PROFILE_ENABLED 1
+#else
+#define RAT25F_PROFILE_ENABLED 0
+#endif
+
+inline constexpr bool kProfileEnabled = RAT25F_PROFILE_ENABLED;
+inline constexpr size_t kTokenTypeCount = static_cast<size_t>(TokenType::EndOfFile) + 1;
+
+// the lexer times one token in kLexSampleEvery and scales up in the report;
+// rules are only counted unless setProfileRuleTiming(true) (two clock reads
+// per parse function entry, which is most of the profiling overhead)
+inline constexpr std::uint32_t kLexSampleEvery = 64;
+
+// set before parsing starts; applies to every thread
+void setProfileRuleTiming(bool on);
+
+struct ProfileCounters {
+    // per Rule
+    std::array<std::uint64_t, kRuleCount> calls{};        // parse function entries
+    std::array<std::uint64_t, kRuleCount> tokens{};       // tokens consumed while innermost
+    std::array<std::uint64_t, kRuleCount> selfTicks{};    // minus nested rules
+    std::array<std::uint64_t, kRuleCount> totalTicks{};   // outermost entry only (no double count on recursion)
+    // per TokenType
+    std::array<std::uint64_t, kTokenTypeCount> lexTokens{};
+    std::array<std::uint64_t, kTokenTypeCount> lexSampled{};
+    std::array<std::uint64_t, kTokenTypeCount> lexTicks{};  // of the sampled tokens
+
+    void add(const ProfileCounters& o);
+    ProfileCounters& operator-=(const ProfileCounters& o);
+};
+
+// sum over all threads so far
+ProfileCounters profileSnapshot();
+
+// table for people, or one JSON object (`label` names the input)
+std::string formatProfile(const ProfileCounters& c, bool json, const std::string& label);
+
+#ifdef RAT25F_PROFILE
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+inline std::uint64_t profileClock() { return __rdtsc(); }
+#elif defined(__aarch64__)
+inline std::uint64_t profileClock() {
+    std::uint64_t v;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(v));
+    return v;
+}
+#else
+#include <chrono>
+inline std::uint64_t profileClock() {
+    return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+}
+#endif
+
+class RuleScope;
+
+// this thread's counters, plus the rule stack the scopes keep
+struct ThreadProfile {
+    ProfileCounters counters;
+    std::array<std::uint32_t, kRuleCount> active{};  // open scopes per rule (recursion)
+    Rule current = Rule::Rat25F;                     // innermost open rule
+    RuleScope* top = nullptr;                        // innermost timed scope
+    std::uint32_t lexTick = 0;                       // sampling phase
+};
+
+ThreadProfile& threadProfile();
+
+extern bool gProfileRuleTiming;
+
+// times one parse function; tokens consumed inside go to the innermost scope
+class RuleScope {
+public:
+    RuleScope(ThreadProfile& tp, Rule r)
+        : tp_(tp), rule_(r), prevRule_(tp.current), timed_(gProfileRuleTiming) {
+        const size_t i = static_cast<size_t>(r);
+        tp_.counters.calls[i]++;
+        tp_.current = r;
+        if (timed_) {
+            parent_ = tp_.top;
+            tp_.top = this;
+            tp_.active[i]++;
+            start_ = profileClock();
+        }
+    }
+    ~RuleScope() {
+        tp_.current = prevRule_;
+        if (!timed_) return;
+        const std::uint64_t elapsed = profileClock() - start_;
+        const size_t i = static_cast<size_t>(rule_);
+        tp_.counters.selfTicks[i] += elapsed - children_;
+        if (--tp_.active[i] == 0) tp_.counters.totalTicks[i] += elapsed;
+        if (parent_) parent_->children_ += elapsed;
+        tp_.top = parent_;
+    }
+    RuleScope(const RuleScope&) = delete;
+    RuleScope& operator=(const RuleScope&) = delete;
+
+private:
+    ThreadProfile& tp_;
+    Rule rule_;
+    Rule prevRule_;
+    bool timed_;
+    RuleScope* parent_ = nullptr;
+    std::uint64_t start_ = 0;
+    std::uint64_t children_ = 0;
+};
+
+#define RAT25F_PROFILE_RULE(tp, rule) RuleScope rat25fRuleScope_((tp), (rule))
+#define RAT25F_PROFILE_TOKEN(tp) ((tp).counters.tokens[static_cast<size_t>((tp).current)]++)
+
+#else
+
+#define RAT25F_PROFILE_RULE(tp, rule) ((void)0)
+#define RAT25F_PROFILE_TOKEN(tp) ((void)0)
+
+#endif
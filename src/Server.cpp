@@ -0,0 +1,267 @@
+#include "Server.h"
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <ostream>
+#include <thread>
+#include "Lexer.h"
+#include "MappedFile.h"
+#include "Sink.h"
+#include "Utf8.h"
+#include "WorkerPool.h"
+
+namespace {
+
+struct Request {
+    std::string id;
+    bool fromFile = false;
+    bool checks = false;
+    bool recover = false;
+    bool trace = false;
+    std::string path;
+    std::string source;
+    std::string bad;   // non-empty: answer `error` with this message
+    bool lost = false; // the stream can no longer be framed: answer, then stop reading
+};
+
+// Bounded FIFO between the reading thread and the workers; push() blocks
+// when full, so a fast client cannot queue unlimited inline sources.
+class RequestQueue {
+public:
+    explicit RequestQueue(size_t capacity) : capacity_(capacity) {}
+
+    void push(Request r) {
+        std::unique_lock<std::mutex> lock(mu_);
+        notFull_.wait(lock, [&] { return q_.size() < capacity_; });
+        q_.push_back(std::move(r));
+        notEmpty_.notify_one();
+    }
+    void close() {
+        std::lock_guard<std::mutex> lock(mu_);
+        closed_ = true;
+        notEmpty_.notify_all();
+    }
+    // false once closed and drained
+    bool pop(Request& r) {
+        std::unique_lock<std::mutex> lock(mu_);
+        notEmpty_.wait(lock, [&] { return !q_.empty() || closed_; });
+        if (q_.empty()) return false;
+        r = std::move(q_.front());
+        q_.pop_front();
+        notFull_.notify_one();
+        return true;
+    }
+
+private:
+    size_t capacity_;
+    std::deque<Request> q_;
+    bool closed_ = false;
+    std::mutex mu_;
+    std::condition_variable notEmpty_, notFull_;
+};
+
+// what a worker keeps warm between requests
+struct Worker {
+    std::shared_ptr<MemorySink> trace = std::make_shared<MemorySink>();
+    std::shared_ptr<NullSink> null = std::make_shared<NullSink>();
+    MappedFile file;
+    std::vector<std::string> diags;
+    std::string response;
+    // reset for every request; built on the worker's own thread by the first
+    // one (a Lexer / Parser belongs to the thread that built it)
+    std::optional<Lexer> lex;
+    std::optional<Parser<FullTrace>> traced;
+    std::optional<Parser<NoTrace>> silent;
+};
+
+// reads (or skips) a payload in steps of this, so a length the input never
+// delivers costs at most one step of memory
+constexpr size_t kPayloadChunk = size_t{1} << 20;
+
+// "<id> file|source [flags] <arg>"; for `source` the payload is read here too,
+// or skipped when the request is refused, so the next request still lines up.
+// false: the input ended (or said quit) and nothing was read.
+bool readRequest(std::istream& in, Request& r) {
+    std::string line;
+    do {
+        if (!std::getline(in, line)) return false;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+    } while (line.find_first_not_of(" \t") == std::string::npos);
+
+    // next space-separated word; `start` is where it begins in the line
+    size_t pos = 0;
+    auto word = [&](size_t& start) {
+        start = line.find_first_not_of(" \t", pos);
+        if (start == std::string::npos) { pos = start = line.size(); return std::string(); }
+        pos = std::min(line.find_first_of(" \t", start), line.size());
+        return line.substr(start, pos - start);
+    };
+    size_t start = 0;
+    r.id = word(start);
+    if (r.id == "quit") return false;
+    const std::string kind = word(start);
+    std::string w = word(start);
+    std::string badOption;   // the first one; the words after it are still read
+    for (; w.size() == 2 && w[0] == '-'; w = word(start)) {
+        if      (w == "-s") r.checks = true;
+        else if (w == "-r") r.recover = true;
+        else if (w == "-t") r.trace = true;
+        else if (badOption.empty()) badOption = w;
+    }
+
+    if (kind == "file") {
+        // the path is the rest of the line, spaces included
+        r.fromFile = true;
+        r.path = line.substr(start);
+        if (!badOption.empty()) r.bad = "unknown option " + badOption;
+        else if (r.path.empty()) r.bad = "missing path";
+        return true;
+    }
+    if (kind == "source") {
+        errno = 0;
+        const unsigned long long n = std::strtoull(w.c_str(), nullptr, 10);
+        if (w.empty() || w.find_first_not_of("0123456789") != std::string::npos || errno == ERANGE) {
+            // without a length there is no telling where the next request starts
+            r.bad = "bad source length: " + w + " (closing: the stream is out of sync)";
+            r.lost = true;
+            return true;
+        }
+        if (!badOption.empty()) r.bad = "unknown option " + badOption;
+        else if (n > kMaxSourceBytes)
+            r.bad = "source of " + w + " bytes is over the " + std::to_string(kMaxSourceBytes) + "-byte limit";
+        if (!r.bad.empty()) {
+            for (unsigned long long left = n; left > 0 && in; ) {
+                const auto step = static_cast<std::streamsize>(std::min<unsigned long long>(left, kPayloadChunk));
+                in.ignore(step);
+                left -= static_cast<unsigned long long>(in.gcount());
+            }
+            return true;
+        }
+        while (r.source.size() < n && in) {
+            const size_t had = r.source.size();
+            r.source.resize(had + std::min<size_t>(n - had, kPayloadChunk));
+            in.read(r.source.data() + had, static_cast<std::streamsize>(r.source.size() - had));
+            r.source.resize(had + static_cast<size_t>(in.gcount()));
+        }
+        if (r.source.size() != n) {
+            r.bad = "source ended after " + std::to_string(r.source.size()) + " of " + w + " bytes";
+            r.source = std::string();
+        }
+        return true;
+    }
+    r.bad = "unknown request '" + kind + "'";
+    return true;
+}
+
+template <class P>
+void runParser(P& parser, std::vector<std::string>& diags) {
+    parser.parse(StartSymbol::Program);
+    for (const Diagnostic& d : parser.diagnostics()) diags.push_back(d.message());
+    if (parser.droppedDiagnostics())
+        diags.push_back("... and " + std::to_string(parser.droppedDiagnostics()) + " more error(s)");
+}
+
+void serve(const Request& r, Worker& w, const TraceConfig& trace, const ParserPolicy& base) {
+    w.diags.clear();
+    w.trace->clear();
+    const char* status = "ok";
+    std::string_view src;
+    size_t bad = utf8::npos;
+    if (!r.bad.empty()) {
+        status = "error";
+        w.diags.push_back(r.bad);
+    } else if (r.fromFile && !w.file.open(r.path)) {
+        status = "error";
+        w.diags.push_back("cannot open input file: " + r.path);
+    } else if (src = r.fromFile ? w.file.view() : std::string_view(r.source);
+               (bad = utf8::firstInvalid(src)) != utf8::npos) {
+        status = "error";
+        w.diags.push_back(utf8::errorMessage(utf8::positionOf(src, bad)));
+    } else {
+        ParserPolicy policy = base;
+        policy.semanticChecks = r.checks;
+        policy.recover = r.recover;
+        try {
+            if (!w.lex) {
+                // both primed on the empty Lexer, so neither reads a stale source
+                w.lex.emplace(std::string_view{});
+                w.traced.emplace(*w.lex, trace, policy, w.trace);
+                w.silent.emplace(*w.lex, trace, policy, w.null);
+            }
+            w.lex->reset(src);
+            if (r.trace) {
+                w.traced->reset(*w.lex, policy);
+                runParser(*w.traced, w.diags);
+            } else {
+                w.silent->reset(*w.lex, policy);
+                runParser(*w.silent, w.diags);
+            }
+        } catch (const std::exception& e) {
+            w.diags.push_back(e.what());
+        }
+        if (!w.diags.empty()) status = "fail";
+    }
+    if (r.fromFile) w.file.close();
+
+    const std::string& text = w.trace->str();
+    w.response.clear();
+    w.response += r.id;
+    w.response += ' ';
+    w.response += status;
+    w.response += ' ' + std::to_string(w.diags.size()) + ' ' + std::to_string(text.size()) + '\n';
+    for (std::string& d : w.diags) {
+        for (char& c : d) if (c == '\n' || c == '\r') c = ' ';   // one line each
+        w.response += d;
+        w.response += '\n';
+    }
+    w.response += text;
+}
+
+} // namespace
+
+int runServer(std::istream& in, std::ostream& out,
+              const TraceConfig& trace, const ParserPolicy& policy, unsigned workers) {
+    if (workers == 0) workers = 1;
+    RequestQueue queue(4 * size_t{workers});
+    std::thread reader([&] {
+        for (;;) {
+            Request r;
+            bool more = true;
+            try {
+                more = readRequest(in, r);
+            } catch (const std::bad_alloc&) {
+                // mid-payload, so the rest of the stream cannot be framed either
+                r.source = std::string();
+                r.bad = "out of memory reading the request";
+                r.lost = true;
+            }
+            if (!more) break;
+            const bool lost = r.lost;
+            queue.push(std::move(r));
+            if (lost) break;
+        }
+        queue.close();
+    });
+
+    std::mutex outMu;
+    std::vector<Worker> pool(workers);
+    parallelFor(workers, workers, [&](size_t i) {
+        Worker& w = pool[i];
+        Request r;
+        while (queue.pop(r)) {
+            serve(r, w, trace, policy);
+            std::lock_guard<std::mutex> lock(outMu);
+            out.write(w.response.data(), static_cast<std::streamsize>(w.response.size()));
+            out.flush();
+        }
+    });
+    reader.join();
+    return out ? 0 : 1;
+}
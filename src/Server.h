@@ -0,0 +1,31 @@
+// Server.h
+// Long-running parse server (--server): line-delimited requests on `in`,
+// one framed response per request on `out`, up to `workers` requests in
+// flight. Each worker keeps its lexer, parsers, sinks, file mapping and
+// response buffer between requests (reset, not rebuilt), so a warm server
+// skips per-invocation startup.
+//
+//   request   <id> file   [-s] [-r] [-t] <path>
+//             <id> source [-s] [-r] [-t] <bytes>\n<exactly that many bytes>
+//             quit                         (or end of input)
+//   response  <id> ok|fail|error <diagnostics> <trace bytes>\n
+//             one line per diagnostic
+//             the trace bytes (-t: tokens and productions as the CLI prints them)
+//
+// -s / -r are the CLI's semantic checks / error recovery. `fail` means the
+// program has errors, `error` that the request itself could not be served.
+// Responses may come back out of order; match them by id.
+//
+// A refused `source` request (unknown option, over kMaxSourceBytes) still has
+// its payload skipped, so the next request lines up. A length that does not
+// parse leaves no way to find the next request: it is answered `error` and
+// the server stops reading, as it does at the end of input.
+#pragma once
+#include <cstddef>
+#include <iosfwd>
+#include "parser.h"
+
+inline constexpr size_t kMaxSourceBytes = size_t{64} << 20;   // per `source` request
+
+int runServer(std::istream& in, std::ostream& out,
+              const TraceConfig& trace, const ParserPolicy& policy, unsigned workers);
@@ -0,0 +1,139 @@
+#include "Sink.h"
+#include <iostream>
+#include "Diagnostic.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#define RAT25F_HAVE_WRITE 1
+#endif
+
+void ProductionSink::token(const Token& t) {
+    std::string line = "Token: ";
+    line += prettyTokenKind(t.type);
+    line += " Lexeme: ";
+    line += t.lexeme;
+    emit(line);
+}
+
+void ProductionSink::relop(const Token& op) {
+    std::string line = "<Relop> -> ";
+    line += op.lexeme;
+    emit(line);
+}
+
+void ProductionSink::diagnostic(const Diagnostic& d) {
+    thread_local std::string line;   // keeps its capacity from one error to the next
+    line.clear();
+    d.formatTo(line);
+    error(line);
+}
+
+void ProductionSink::write(std::string_view text) {
+    while (!text.empty()) {
+        size_t nl = text.find('\n');
+        if (nl == std::string_view::npos) { emit(text); break; }
+        emit(text.substr(0, nl));
+        text.remove_prefix(nl + 1);
+    }
+}
+
+void ConsoleSink::emit(std::string_view line) {
+    std::cout << line << "\n";
+}
+
+void CountingSink::token(const Token& t) {
+    tokens++;
+    lines++;
+    bytes += 7 + std::string_view(prettyTokenKind(t.type)).size() + 9 + t.lexeme.size() + 1;
+}
+
+void MemorySink::token(const Token& t) {
+    append("Token: ");
+    append(prettyTokenKind(t.type));
+    append(" Lexeme: ");
+    append(t.lexeme);
+    buf_.push_back('\n');
+}
+
+void MemorySink::relop(const Token& op) {
+    append("<Relop> -> ");
+    append(op.lexeme);
+    buf_.push_back('\n');
+}
+
+// ------------ BufferedFileSink ------------
+BufferedFileSink::BufferedFileSink(const std::string& path, size_t capacity) : capacity_(capacity) {
+    open(path);
+    buf_.reserve(capacity_ + 4096);
+}
+
+BufferedFileSink::BufferedFileSink(int fd, size_t capacity) : capacity_(capacity) {
+    open(fd);
+    buf_.reserve(capacity_ + 4096);
+}
+
+BufferedFileSink::~BufferedFileSink() {
+    flush();
+    close();
+}
+
+bool BufferedFileSink::reopen(const std::string& path) {
+    flush();
+    close();
+    open(path);
+    return ok();
+}
+
+bool BufferedFileSink::reopen(int fd) {
+    flush();
+    close();
+    open(fd);
+    return ok();
+}
+
+void BufferedFileSink::open(const std::string& path) {
+#ifdef RAT25F_HAVE_WRITE
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    ownsFd_ = fd_ >= 0;
+#else
+    file_ = std::fopen(path.c_str(), "wb");
+#endif
+}
+
+void BufferedFileSink::open(int fd) {
+#ifdef RAT25F_HAVE_WRITE
+    fd_ = fd;
+    ownsFd_ = false;
+#else
+    file_ = (fd == 2) ? stderr : stdout;
+#endif
+}
+
+void BufferedFileSink::close() {
+#ifdef RAT25F_HAVE_WRITE
+    if (ownsFd_) ::close(fd_);
+    fd_ = -1;
+    ownsFd_ = false;
+#else
+    if (file_ && file_ != stdout && file_ != stderr) std::fclose(file_);
+    file_ = nullptr;
+#endif
+}
+
+void BufferedFileSink::flush() {
+    const char* p = buf_.data();
+    size_t left = buf_.size();
+#ifdef RAT25F_HAVE_WRITE
+    while (left > 0 && fd_ >= 0) {
+        ssize_t n = ::write(fd_, p, left);
+        if (n < 0) { if (errno == EINTR) continue; break; }
+        p += n;
+        left -= static_cast<size_t>(n);
+    }
+#else
+    if (file_ && left) { std::fwrite(p, 1, left, file_); std::fflush(file_); }
+#endif
+    buf_.clear();
+}
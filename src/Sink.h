@@ -0,0 +1,106 @@
+// Sink.h
+#pragma once
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include "Grammar.h"
+#include "Token.h"
+
+struct Diagnostic;
+
+// Where the parser's text goes: production lines, echoed tokens, errors.
+// Every hook has a default in terms of emit(), so a sink only has to
+// implement emit() and can override the rest to skip formatting.
+struct ProductionSink {
+    virtual ~ProductionSink() = default;
+    virtual void emit(std::string_view line) = 0;
+    virtual void production(Prod p) { emit(prodInfo(p).text); }
+    virtual void token(const Token& t);            // "Token: <kind> Lexeme: <lexeme>"
+    virtual void relop(const Token& op);           // "<Relop> -> <lexeme>"
+    virtual void error(std::string_view msg) { emit(msg); }
+    // error() with the formatted message; the text is built in a reused buffer
+    virtual void diagnostic(const Diagnostic& d);
+    virtual void write(std::string_view text);     // pre-formatted lines, each ending in '\n'
+    virtual void flush() {}
+};
+
+struct ConsoleSink : ProductionSink {
+    void emit(std::string_view line) override;
+};
+
+// Drops everything (recognize-only runs that still want a sink object).
+struct NullSink : ProductionSink {
+    void emit(std::string_view) override {}
+    void production(Prod) override {}
+    void token(const Token&) override {}
+    void relop(const Token&) override {}
+    void error(std::string_view) override {}
+    void diagnostic(const Diagnostic&) override {}
+};
+
+// Counts what would have been written, without writing it.
+struct CountingSink : ProductionSink {
+    void emit(std::string_view line) override { lines++; bytes += line.size() + 1; }
+    void token(const Token& t) override;
+    void relop(const Token& op) override { lines++; bytes += 11 + op.lexeme.size() + 1; }
+    void error(std::string_view msg) override { errors++; emit(msg); }
+
+    size_t lines = 0;
+    size_t bytes = 0;
+    size_t tokens = 0;
+    size_t errors = 0;
+};
+
+// Builds output in one growing in-memory block; str() hands it out.
+class MemorySink : public ProductionSink {
+public:
+    void emit(std::string_view line) override { append(line); buf_.push_back('\n'); }
+    void token(const Token& t) override;
+    void relop(const Token& op) override;
+
+    void write(std::string_view text) override { append(text); }
+
+    const std::string& str() const { return buf_; }
+    void clear() { buf_.clear(); }
+
+protected:
+    void append(std::string_view s) { buf_.append(s.data(), s.size()); }
+    std::string buf_;
+};
+
+// MemorySink that drains to a file descriptor with plain write() once the
+// block reaches `capacity`, and on flush()/destruction.
+class BufferedFileSink : public MemorySink {
+public:
+    static constexpr size_t kDefaultCapacity = size_t{1} << 20;
+
+    explicit BufferedFileSink(const std::string& path, size_t capacity = kDefaultCapacity);
+    explicit BufferedFileSink(int fd, size_t capacity = kDefaultCapacity);  // not owned (e.g. 1 = stdout)
+    ~BufferedFileSink() override;
+    BufferedFileSink(const BufferedFileSink&) = delete;
+    BufferedFileSink& operator=(const BufferedFileSink&) = delete;
+
+    bool ok() const { return fd_ >= 0 || file_ != nullptr; }
+    // flush and close, then write to another file; the buffer is kept
+    bool reopen(const std::string& path);
+    bool reopen(int fd);
+    void emit(std::string_view line) override { MemorySink::emit(line); maybeFlush(); }
+    void token(const Token& t) override { MemorySink::token(t); maybeFlush(); }
+    void relop(const Token& op) override { MemorySink::relop(op); maybeFlush(); }
+    void flush() override;
+    void write(std::string_view text) override { append(text); maybeFlush(); }
+
+protected:
+    void maybeFlush() { if (buf_.size() >= capacity_) flush(); }
+
+private:
+    void open(const std::string& path);
+    void open(int fd);
+    void close();
+
+    int fd_ = -1;
+    bool ownsFd_ = false;
+    std::FILE* file_ = nullptr;   // fallback where there is no write()
+    size_t capacity_;
+};
@@ -0,0 +1,132 @@
+#include "SplitParse.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include "Lexer.h"
+#include "Utf8.h"
+#include "WorkerPool.h"
+
+bool findFunctionSpans(std::string_view src, FunctionSpans& out, size_t from, size_t until) {
+    out.starts.clear();
+    out.tail = 0;
+    Lexer lex(src.substr(from));   // lexemes still point into src
+    long depth = 0;
+    bool inFunction = false;
+    for (Token t = lex.nextToken(); t.type != TokenType::EndOfFile; t = lex.nextToken()) {
+        const size_t off = static_cast<size_t>(t.lexeme.data() - src.data());
+        if (t.type == TokenType::String) continue;   // banners / literals
+        if (!inFunction && t.type == TokenType::Keyword && t.id == TokId::Function) {
+            out.starts.push_back(off);
+            if (off >= until) { out.tail = 0; return true; }
+            inFunction = true;
+            continue;
+        }
+        if (!inFunction) {
+            // before the first function, or a non-function after a closed body: tail
+            if (out.starts.empty()) return false;
+            break;
+        }
+        if (t.type == TokenType::Separator && t.id == TokId::LBrace) {
+            depth++;
+        } else if (t.type == TokenType::Separator && t.id == TokId::RBrace) {
+            if (--depth < 0) return false;
+            if (depth == 0) { inFunction = false; out.tail = off + 1; }
+        }
+    }
+    return !out.starts.empty() && !inFunction;
+}
+
+void SourceCursor::seek(size_t offset) {
+    // line/col for the byte at `offset` as the Lexer reports them (col in
+    // codepoints): a '\n' byte is already on the next line (col 0). Past the
+    // end: the last byte.
+    if (offset >= src_.size()) offset = src_.empty() ? 0 : src_.size() - 1;
+    if (pos_ <= offset && pos_ < src_.size()) {
+        const char* b = src_.data() + pos_;
+        const char* e = src_.data() + offset + 1;
+        newlines_ += static_cast<size_t>(std::count(b, e, '\n'));
+        for (const char* q = e; q != b;)
+            if (*--q == '\n') { lastNl_ = static_cast<size_t>(q - src_.data()); break; }
+        pos_ = offset + 1;
+    }
+    line = 1 + newlines_;
+    if (src_.empty()) { col = 0; return; }
+    if (hasNl() && lastNl_ == offset) col = 0;
+    else col = utf8::codepoints(src_.data() + (hasNl() ? lastNl_ + 1 : 0), src_.data() + offset) + 1;
+}
+
+bool parseSpan(std::string_view src, size_t begin, size_t end, size_t line, size_t col,
+               bool tail, const TraceConfig& trace, const ParserPolicy& policy,
+               SpanResult& out) {
+    auto sink = std::make_shared<MemorySink>();
+    out.diags.clear();
+    out.dropped = 0;
+    try {
+        Lexer lex(src.substr(begin, end - begin), line, col);
+        Parser<FullTrace> parser(lex, trace, policy, sink);
+        if (tail) parser.parseProgramTail();
+        else      parser.parseFunctionUnit();
+        out.diags = parser.diagnostics();
+        out.dropped = parser.droppedDiagnostics();
+        // the slice's end of input sits on its last byte, where the whole
+        // file has the next token instead; a diagnostic there may differ
+        out.exact = true;
+        if (!out.diags.empty() && end > begin) {
+            SourceCursor last(src.substr(begin, end - begin));
+            last.seek(end - begin - 1);
+            const size_t eofLine = line + last.line - 1;
+            const size_t eofCol = last.line == 1 ? col + last.col - 1 : last.col;
+            for (const Diagnostic& d : out.diags)
+                if (d.line == eofLine && d.col == eofCol) out.exact = false;
+        }
+        out.ok = true;
+    } catch (const std::exception&) {
+        out.ok = false;
+    }
+    out.text = sink->str();
+    return out.ok;
+}
+
+void writeProgram(const TraceConfig& trace, const std::vector<std::string_view>& texts,
+                  ProductionSink& sink) {
+    // the productions parseRat25F prints around each <Function>
+    TraceFilter filter(trace);
+    auto prod = [&](Prod p) { if (filter.show[static_cast<size_t>(p)]) sink.production(p); };
+    prod(Prod::Rat25F);
+    prod(Prod::OptFuncDefs);
+    prod(Prod::FuncDefs);
+    for (size_t i = 0; i + 1 < texts.size(); ++i) {
+        if (i > 0) prod(Prod::FuncDefsPrime);
+        sink.write(texts[i]);
+    }
+    if (!texts.empty()) sink.write(texts.back());
+}
+
+bool parseProgramSplit(std::string_view src, const TraceConfig& trace,
+                       const ParserPolicy& policy, unsigned threads, ProductionSink& sink) {
+    FunctionSpans spans;
+    if (!findFunctionSpans(src, spans) || spans.starts.size() < 2) return false;
+
+    const size_t n = spans.starts.size();
+    std::vector<SpanResult> pieces(n + 1);   // n functions + the tail
+    std::vector<std::pair<size_t, size_t>> startPos(n + 1);
+    SourceCursor cursor(src);
+    for (size_t i = 0; i <= n; ++i) {
+        cursor.seek(i < n ? spans.starts[i] : spans.tail);
+        startPos[i] = { cursor.line, cursor.col };
+    }
+
+    parallelFor(n + 1, threads, [&](size_t i) {
+        const auto [line, col] = startPos[i];
+        size_t begin = i < n ? spans.starts[i] : spans.tail;
+        size_t end = i + 1 < n ? spans.starts[i + 1] : i < n ? spans.tail : src.size();
+        parseSpan(src, begin, end, line, col, i == n, trace, policy, pieces[i]);
+    });
+    for (const SpanResult& p : pieces) if (!p.ok) return false;
+
+    std::vector<std::string_view> texts;
+    texts.reserve(n + 1);
+    for (const SpanResult& p : pieces) texts.emplace_back(p.text);
+    writeProgram(trace, texts, sink);
+    return true;
+}
@@ -0,0 +1,62 @@
+// SplitParse.h
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "parser.h"
+
+// Top-level <Function> boundaries found by a pre-scan with the Lexer:
+// `function` keywords at brace depth 0, up to where the program tail begins.
+struct FunctionSpans {
+    std::vector<size_t> starts;   // byte offset of each top-level `function`
+    size_t tail = 0;              // one past the last function's closing '}'
+};
+
+// False when the input doesn't start (after banner strings) with a function.
+// The scan may start at `from`, the offset of a top-level `function`; it
+// stops early once it records a function at or past `until` (out.tail = 0).
+bool findFunctionSpans(std::string_view src, FunctionSpans& out,
+                       size_t from = 0, size_t until = static_cast<size_t>(-1));
+
+// line/col the Lexer reports for a byte; offsets must be visited in order
+class SourceCursor {
+public:
+    explicit SourceCursor(std::string_view src) : src_(src) {}
+    void seek(size_t offset);
+    size_t line = 1, col = 0;
+
+private:
+    bool hasNl() const { return lastNl_ != static_cast<size_t>(-1); }
+    std::string_view src_;
+    size_t pos_ = 0, newlines_ = 0, lastNl_ = static_cast<size_t>(-1);
+};
+
+// One span of a split program: a <Function> (parseFunctionUnit) or the
+// program tail (parseProgramTail), parsed by its own Lexer/Parser into a
+// MemorySink. ok is false if the span threw; its text is then partial.
+struct SpanResult {
+    std::string text;
+    DiagnosticList diags;            // with policy.recover
+    size_t dropped = 0;
+    bool ok = false;
+    bool exact = true;               // diagnostics positioned as in the whole file
+};
+// [begin, end) of src, the Lexer starting at line/col
+bool parseSpan(std::string_view src, size_t begin, size_t end, size_t line, size_t col,
+               bool tail, const TraceConfig& trace, const ParserPolicy& policy,
+               SpanResult& out);
+
+// Write span texts (functions..., tail) with the productions parseRat25F
+// prints around them; equals the trace of a serial parse.
+void writeProgram(const TraceConfig& trace, const std::vector<std::string_view>& texts,
+                  ProductionSink& sink);
+
+// Parse `src` as a <Rat25F> program, the function definitions spread over
+// `threads` workers, each with its own Lexer/Parser/MemorySink. The pieces
+// are written to `sink` in source order, so the text equals a serial
+// parse. Returns false, having written nothing, if the input can't be
+// split or any piece fails; the caller then parses serially, which also
+// reproduces the exact error.
+bool parseProgramSplit(std::string_view src, const TraceConfig& trace,
+                       const ParserPolicy& policy, unsigned threads, ProductionSink& sink);
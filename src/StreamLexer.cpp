@@ -0,0 +1,151 @@
+#include "StreamLexer.h"
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+#include "Utf8.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#define RAT25F_HAVE_READ 1
+#endif
+
+// ------------ ChunkReader ------------
+ChunkReader::ChunkReader(int fd, size_t chunkSize) : fd_(fd), chunk_(chunkSize ? chunkSize : 1) {
+    for (Slot& s : slots_) s.data.reset(new char[chunk_]);
+    thread_ = std::thread([this] { run(); });
+}
+
+ChunkReader::~ChunkReader() {
+    stop_ = true;
+    cv_.notify_all();
+    thread_.join();
+}
+
+long ChunkReader::readSome(char* dst) {
+#ifdef RAT25F_HAVE_READ
+    for (;;) {
+        // wake up now and then so a destructor never waits on an idle producer
+        pollfd p{fd_, POLLIN, 0};
+        int r = ::poll(&p, 1, 100);
+        if (stop_) return 0;
+        if (r < 0 && errno != EINTR) return -1;
+        if (r <= 0) continue;
+        ssize_t n = ::read(fd_, dst, chunk_);
+        if (n < 0 && errno == EINTR) continue;
+        return static_cast<long>(n);
+    }
+#else
+    // no partial reads here: blocks until the chunk is full or the input ends
+    std::FILE* f = fd_ == 0 ? stdin : nullptr;
+    if (!f) return -1;
+    size_t n = std::fread(dst, 1, chunk_, f);
+    if (n == 0) return std::ferror(f) ? -1 : 0;
+    return static_cast<long>(n);
+#endif
+}
+
+void ChunkReader::run() {
+    for (size_t i = 0;; i ^= 1) {
+        Slot& s = slots_[i];
+        {
+            std::unique_lock<std::mutex> lock(mu_);
+            cv_.wait(lock, [&] { return !s.full || stop_; });
+            if (stop_) return;
+        }
+        long n = readSome(s.data.get());   // the consumer may use the other slot meanwhile
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            if (n <= 0) {
+                done_ = true;
+                error_ = n < 0;
+            } else {
+                s.size = static_cast<size_t>(n);
+                s.full = true;
+            }
+        }
+        cv_.notify_all();
+        if (n <= 0) return;
+    }
+}
+
+bool ChunkReader::readInto(std::string& out, bool wait) {
+    Slot& s = slots_[next_];
+    std::unique_lock<std::mutex> lock(mu_);
+    if (wait) cv_.wait(lock, [&] { return s.full || done_; });
+    if (!s.full) return false;
+    out.append(s.data.get(), s.size);
+    s.full = false;
+    next_ ^= 1;
+    lock.unlock();
+    cv_.notify_all();
+    return true;
+}
+
+bool ChunkReader::exhausted() {
+    std::lock_guard<std::mutex> lock(mu_);
+    return done_ && !slots_[next_].full;
+}
+
+// ------------ StreamLexer ------------
+StreamLexer::StreamLexer(int fd, size_t chunkSize) : reader_(fd, chunkSize) {
+    buf_.reserve(2 * chunkSize);
+}
+
+size_t StreamLexer::safeCut() {
+    // strings have no escapes, so quote parity from a safe point is exact
+    for (size_t i = scanned_; i < buf_.size(); ++i) {
+        const char c = buf_[i];
+        if (c == '"') inString_ = !inString_;
+        else if (c == '\n' && !inString_) safe_ = i + 1;
+    }
+    scanned_ = buf_.size();
+    return safe_;
+}
+
+bool StreamLexer::refill() {
+    for (;;) {
+        if (cut_) {
+            // the window has been lexed; keep only the tail after it
+            newlines_ += static_cast<size_t>(std::count(buf_.begin(), buf_.begin() + static_cast<std::ptrdiff_t>(cut_), '\n'));
+            buf_.erase(0, cut_);
+            scanned_ -= cut_;
+            safe_ = 0;
+            cut_ = 0;
+        }
+        if (inputDone_) {
+            if (buf_.empty()) return false;
+            cut_ = buf_.size();   // the rest, whatever it ends in
+            break;
+        }
+        if (!reader_.readInto(buf_, false)) {
+            if (reader_.exhausted()) { inputDone_ = true; continue; }
+            if (idle_) idle_();
+            if (!reader_.readInto(buf_)) { inputDone_ = true; continue; }
+        }
+        if ((cut_ = safeCut()) != 0) break;
+    }
+    // line/col of buf_[0] as the whole-input Lexer counts them: it follows a
+    // '\n' (col 1), or is one itself (already on the next line, col 0)
+    const std::string_view window(buf_.data(), cut_);
+    if (!badUtf8_) {
+        if (const size_t bad = utf8::firstInvalid(window); bad != utf8::npos) {
+            TokenPos pos = utf8::positionOf(window, bad);
+            pos.line += static_cast<std::uint32_t>(newlines_);
+            badUtf8_ = pos;
+        }
+    }
+    const bool nl = buf_[0] == '\n';
+    lex_ = Lexer(std::string_view(buf_.data(), cut_), 1 + newlines_ + (nl ? 1 : 0), nl ? 0 : 1);
+    return true;
+}
+
+Token StreamLexer::nextToken() {
+    for (;;) {
+        Token t = lex_.nextToken();
+        if (t.type != TokenType::EndOfFile) return t;
+        last_ = t;
+        if (!refill()) return last_;
+    }
+}
@@ -0,0 +1,93 @@
+// StreamLexer.h
+// Token source for pipes / stdin in bounded memory. A background thread
+// reads fixed-size chunks into two slots (double buffering) while the Lexer
+// runs over a window of what has arrived. Each window ends just after a
+// newline outside a string, so no token spans a refill and line/col carry
+// over exactly; the window only grows past ~2 chunks for a single line or
+// string that is longer than that.
+//
+// A token's lexeme stays valid until the next nextToken() call.
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include "Lexer.h"
+#include "TokenSource.h"
+
+// reads `fd` on its own thread, chunkSize bytes (or what is available) per slot
+class ChunkReader {
+public:
+    ChunkReader(int fd, size_t chunkSize);
+    ~ChunkReader();
+    ChunkReader(const ChunkReader&) = delete;
+    ChunkReader& operator=(const ChunkReader&) = delete;
+
+    // appends the next chunk to `out`; false once the input is exhausted.
+    // wait = false returns false at once when no chunk is ready (see exhausted())
+    bool readInto(std::string& out, bool wait = true);
+    bool exhausted();
+    bool failed() const { return error_; }   // a read error ended the input
+
+private:
+    struct Slot {
+        std::unique_ptr<char[]> data;
+        size_t size = 0;
+        bool full = false;
+    };
+    void run();
+    long readSome(char* dst);   // <= 0: end of input (< 0 error)
+
+    int fd_;
+    size_t chunk_;
+    Slot slots_[2];
+    size_t next_ = 0;           // slot the consumer takes next
+    std::mutex mu_;
+    std::condition_variable cv_;
+    bool done_ = false;
+    std::atomic<bool> error_{false};
+    std::atomic<bool> stop_{false};
+    std::thread thread_;
+};
+
+class StreamLexer final : public TokenSource {
+public:
+    static constexpr size_t kChunkSize = size_t{64} << 10;
+
+    explicit StreamLexer(int fd = 0, size_t chunkSize = kChunkSize);
+    Token nextToken() override;
+    // the current window's Lexer; the Parser only asks about its current token
+    TokenPos position(const Token& t) const override { return lex_.position(t); }
+
+    // called when the next chunk has not arrived yet, just before waiting
+    // for it (flush output here so it keeps up with a slow producer)
+    void setIdleHook(std::function<void()> fn) { idle_ = std::move(fn); }
+
+    bool readError() const { return reader_.failed(); }
+    // where the first invalid UTF-8 byte was, if any window held one; windows
+    // start on a line, so none splits a sequence
+    const std::optional<TokenPos>& invalidUtf8() const { return badUtf8_; }
+
+private:
+    bool refill();        // next window into lex_; false at end of input
+    size_t safeCut();     // just past the last '\n' outside a string, 0 if none yet
+
+    ChunkReader reader_;
+    std::string buf_;     // current window [0, cut_) + carried-over tail
+    size_t cut_ = 0;
+    size_t scanned_ = 0;  // safeCut() has looked at buf_[0, scanned_)
+    size_t safe_ = 0;
+    bool inString_ = false;
+    size_t newlines_ = 0; // '\n' bytes before buf_[0] in the whole input
+    bool inputDone_ = false;
+    std::optional<TokenPos> badUtf8_;
+    std::function<void()> idle_;
+    Lexer lex_{std::string_view{}};
+    Token last_{TokenType::EndOfFile, TokId::None, {}, 1, 0};
+};
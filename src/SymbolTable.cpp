@@ -0,0 +1,65 @@
+#include "SymbolTable.h"
+
+void SymbolTable::reset() {
+    globals_.clear(); locals_.clear(); funcs_.clear(); pending_.clear();
+    globalSlot_.clear(); funcSlot_.clear(); localSlot_.clear(); localGen_.clear();
+    gen_ = 1;
+    inFunction_ = false;
+}
+
+void SymbolTable::setSlot(std::vector<std::uint32_t>& v, std::uint32_t name, std::uint32_t s) {
+    if (name >= v.size()) v.resize(name + 1 + name / 2, 0);   // IDs are dense
+    v[name] = s;
+}
+
+void SymbolTable::enterFunction() {
+    inFunction_ = true;
+    locals_.clear();
+    ++gen_;   // invalidates every localSlot_ entry at once
+}
+
+void SymbolTable::leaveFunction() { inFunction_ = false; }
+
+const SymbolTable::Var* SymbolTable::findLocal(std::uint32_t name) const {
+    if (slot(localGen_, name) != gen_) return nullptr;
+    return &locals_[localSlot_[name] - 1];
+}
+
+bool SymbolTable::declareVar(std::uint32_t name, TokId type, std::uint32_t line, std::uint32_t col) {
+    if (inFunction_) {
+        if (findLocal(name)) return false;
+        locals_.push_back({ name, type, line, col });
+        setSlot(localSlot_, name, static_cast<std::uint32_t>(locals_.size()));
+        setSlot(localGen_, name, gen_);
+    } else {
+        if (slot(globalSlot_, name)) return false;
+        globals_.push_back({ name, type, line, col });
+        setSlot(globalSlot_, name, static_cast<std::uint32_t>(globals_.size()));
+    }
+    return true;
+}
+
+bool SymbolTable::declareFunction(std::uint32_t name, std::uint32_t arity,
+                                  std::uint32_t line, std::uint32_t col) {
+    if (slot(funcSlot_, name)) return false;
+    funcs_.push_back({ name, arity, line, col });
+    setSlot(funcSlot_, name, static_cast<std::uint32_t>(funcs_.size()));
+    return true;
+}
+
+void SymbolTable::setTypesSince(size_t mark, TokId type) {
+    auto& s = scope();
+    for (size_t i = mark; i < s.size(); ++i) s[i].type = type;
+}
+
+const SymbolTable::Var* SymbolTable::findVar(std::uint32_t name) const {
+    if (inFunction_)
+        if (const Var* v = findLocal(name)) return v;
+    std::uint32_t s = slot(globalSlot_, name);
+    return s ? &globals_[s - 1] : nullptr;
+}
+
+const SymbolTable::Func* SymbolTable::findFunction(std::uint32_t name) const {
+    std::uint32_t s = slot(funcSlot_, name);
+    return s ? &funcs_[s - 1] : nullptr;
+}
@@ -0,0 +1,68 @@
+// SymbolTable.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "Token.h"
+
+// Global + function scope for semantic checks, indexed by Interner ID.
+// Each scope is a flat array of symbols; per-name slot arrays point into
+// them, so declare/lookup are a couple of array loads and leaving a function
+// scope is O(1) (a generation bump, no clearing).
+class SymbolTable {
+public:
+    struct Var {
+        std::uint32_t name;
+        TokId type;                      // qualifier keyword (None until known)
+        std::uint32_t line, col;
+    };
+    struct Func {
+        std::uint32_t name;
+        std::uint32_t arity;
+        std::uint32_t line, col;
+    };
+    // a use inside a function body that may refer to a global or to a later
+    // function; the parser checks these once the global declarations are in
+    struct Use {
+        std::uint32_t name;
+        std::uint32_t arity;             // calls only
+        bool call;
+        std::uint32_t line, col;
+    };
+
+    void reset();
+
+    void enterFunction();
+    void leaveFunction();
+    bool inFunction() const { return inFunction_; }
+
+    // false if the name is already declared in the current scope
+    bool declareVar(std::uint32_t name, TokId type, std::uint32_t line, std::uint32_t col);
+    bool declareFunction(std::uint32_t name, std::uint32_t arity, std::uint32_t line, std::uint32_t col);
+    // fill in the qualifier for variables declared since mark (Parameter: <IDs> <Qualifier>)
+    size_t mark() const { return scope().size(); }
+    void setTypesSince(size_t mark, TokId type);
+
+    const Var* findVar(std::uint32_t name) const;    // function scope, then global
+    const Func* findFunction(std::uint32_t name) const;
+
+    void defer(const Use& use) { pending_.push_back(use); }
+    std::vector<Use>& pending() { return pending_; }
+
+private:
+    static std::uint32_t slot(const std::vector<std::uint32_t>& v, std::uint32_t name) {
+        return name < v.size() ? v[name] : 0;
+    }
+    static void setSlot(std::vector<std::uint32_t>& v, std::uint32_t name, std::uint32_t s);
+    std::vector<Var>& scope() { return inFunction_ ? locals_ : globals_; }
+    const std::vector<Var>& scope() const { return inFunction_ ? locals_ : globals_; }
+    const Var* findLocal(std::uint32_t name) const;
+
+    // slots hold index+1, 0 = not declared
+    std::vector<Var> globals_, locals_;
+    std::vector<Func> funcs_;
+    std::vector<std::uint32_t> globalSlot_, funcSlot_, localSlot_, localGen_;
+    std::uint32_t gen_ = 1;              // current function scope
+    bool inFunction_ = false;
+    std::vector<Use> pending_;
+};
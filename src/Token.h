@@ -1,7 +1,9 @@
 #pragma once
-#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
 
-enum class TokenType {
+enum class TokenType : std::uint8_t {
     Keyword,
     Identifier,
     Integer,
@@ -13,9 +15,104 @@ enum class TokenType {
     EndOfFile
 };
 
+// sub-kind: which keyword / operator / separator (None for everything else)
+enum class TokId : std::uint8_t {
+    None,
+    // keywords
+    Integer, Int, Real, Boolean, If, Else, Fi, While, Return, Get, Put, Function,
+    // soft keywords: lexed as Identifier, but tagged so nobody compares text
+    True, False,
+    // operators
+    Assign, Plus, Minus, Star, Slash, Less, Greater, LessEq, GreaterEq, EqEq, NotEq,
+    AndAnd, OrOr, Bang, Amp, Pipe,
+    // separators
+    LParen, RParen, LBrace, RBrace, LBracket, RBracket, Comma, Semicolon,
+    Count
+};
+static_assert(static_cast<int>(TokId::Count) <= 64, "TokId sets are 64-bit masks");
+
+// FIRST-set style masks over TokId
+constexpr std::uint64_t tokBit(TokId id) { return std::uint64_t{1} << static_cast<unsigned>(id); }
+template <class... Ids>
+constexpr std::uint64_t tokSet(Ids... ids) { return (tokBit(ids) | ... | 0); }
+
+// source spelling of a keyword / operator / separator
+constexpr const char* tokIdText(TokId id) {
+    switch (id) {
+        case TokId::Integer:   return "integer";
+        case TokId::Int:       return "int";
+        case TokId::Real:      return "real";
+        case TokId::Boolean:   return "boolean";
+        case TokId::If:        return "if";
+        case TokId::Else:      return "else";
+        case TokId::Fi:        return "fi";
+        case TokId::While:     return "while";
+        case TokId::Return:    return "return";
+        case TokId::Get:       return "get";
+        case TokId::Put:       return "put";
+        case TokId::Function:  return "function";
+        case TokId::True:      return "true";
+        case TokId::False:     return "false";
+        case TokId::Assign:    return "=";
+        case TokId::Plus:      return "+";
+        case TokId::Minus:     return "-";
+        case TokId::Star:      return "*";
+        case TokId::Slash:     return "/";
+        case TokId::Less:      return "<";
+        case TokId::Greater:   return ">";
+        case TokId::LessEq:    return "<=";
+        case TokId::GreaterEq: return ">=";
+        case TokId::EqEq:      return "==";
+        case TokId::NotEq:     return "!=";
+        case TokId::AndAnd:    return "&&";
+        case TokId::OrOr:      return "||";
+        case TokId::Bang:      return "!";
+        case TokId::Amp:       return "&";
+        case TokId::Pipe:      return "|";
+        case TokId::LParen:    return "(";
+        case TokId::RParen:    return ")";
+        case TokId::LBrace:    return "{";
+        case TokId::RBrace:    return "}";
+        case TokId::LBracket:  return "[";
+        case TokId::RBracket:  return "]";
+        case TokId::Comma:     return ",";
+        case TokId::Semicolon: return ";";
+        case TokId::None:
+        case TokId::Count:     break;
+    }
+    return "";
+}
+
+// pretty print for token type
+constexpr const char* prettyTokenKind(TokenType t) {
+    switch (t) {
+        case TokenType::Identifier: return "Identifier";
+        case TokenType::Keyword:    return "Keyword";
+        case TokenType::Integer:    return "Integer";
+        case TokenType::Real:       return "Real";
+        case TokenType::Operator:   return "Operator";
+        case TokenType::Separator:  return "Separator";
+        case TokenType::String:     return "String";
+        case TokenType::Unknown:    return "Unknown";
+        case TokenType::EndOfFile:  return "EOF";
+    }
+    return "Unknown";
+}
+
+// lexeme is a view into the Lexer's source buffer (string literals: the
+// bytes between the quotes), so a Token is only valid while that buffer is.
+// line/col are where the token starts (the opening quote of a string; for
+// EndOfFile, the last byte). Sources that defer them (TokenCursor) leave
+// them 0; ask TokenSource::position() instead.
 struct Token {
     TokenType type;
-    std::string lexeme;
-    size_t line;
-    size_t col;
+    TokId id;
+    std::string_view lexeme;
+    std::uint32_t line;
+    std::uint32_t col;
+};
+static_assert(sizeof(Token) <= 32, "Token is copied per advance(); keep it small");
+
+struct TokenPos {
+    std::uint32_t line = 0, col = 0;
 };
@@ -0,0 +1,85 @@
+#include "TokenBuffer.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include "CharScan.h"
+#include "Lexer.h"
+#include "Utf8.h"
+
+bool TokenBuffer::build(std::string_view src) {
+    clear();
+    if (src.size() >= std::numeric_limits<std::uint32_t>::max()) return false;
+    src_ = src;
+    ascii_ = scan::asciiEnd(src.data(), src.data() + src.size()) == src.data() + src.size();
+    // typical source runs 3-5 bytes a token; the vectors grow past this if needed
+    const size_t guess = src.size() / 4 + 16;
+    type_.reserve(guess);
+    id_.reserve(guess);
+    offset_.reserve(guess);
+    length_.reserve(guess);
+
+    Lexer lex(src);
+    for (;;) {
+        const Token t = lex.nextToken();
+        const bool eof = t.type == TokenType::EndOfFile;
+        type_.push_back(static_cast<std::uint8_t>(t.type));
+        id_.push_back(static_cast<std::uint8_t>(t.id));
+        offset_.push_back(eof ? static_cast<std::uint32_t>(src.size())
+                              : static_cast<std::uint32_t>(t.lexeme.data() - src.data()));
+        length_.push_back(static_cast<std::uint32_t>(t.lexeme.size()));
+        if (eof) break;
+    }
+
+    for (const char* p = src.data(), *end = p + src.size();
+         (p = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)))) != nullptr; ++p)
+        newlines_.push_back(static_cast<std::uint32_t>(p - src.data()));
+    return true;
+}
+
+void TokenBuffer::clear() {
+    src_ = {};
+    ascii_ = true;
+    type_.clear();
+    id_.clear();
+    offset_.clear();
+    length_.clear();
+    newlines_.clear();
+}
+
+Token TokenBuffer::token(size_t i) const {
+    if (i >= size()) {
+        if (empty()) return { TokenType::EndOfFile, TokId::None, {}, 0, 0 };
+        i = size() - 1;
+    }
+    return { type(i), id(i), lexeme(i), 0, 0 };
+}
+
+TokenPos TokenBuffer::positionOf(size_t offset) const {
+    // newlines at or before the byte; the last of them starts its line
+    auto it = std::upper_bound(newlines_.begin(), newlines_.end(), offset);
+    const auto line = static_cast<std::uint32_t>(1 + (it - newlines_.begin()));
+    const size_t from = it == newlines_.begin() ? 0 : *--it + size_t{1};
+    if (offset < from) return { line, 0 };   // the '\n' itself
+    if (ascii_) return { line, static_cast<std::uint32_t>(offset - from + 1) };
+    return { line, static_cast<std::uint32_t>(utf8::codepoints(src_.data() + from, src_.data() + offset) + 1) };
+}
+
+TokenPos TokenBuffer::position(size_t i) const {
+    if (empty()) return { 1, 0 };
+    if (i >= size()) i = size() - 1;
+    if (type(i) == TokenType::EndOfFile)   // the Lexer stops on the last byte
+        return src_.empty() ? TokenPos{ 1, 0 } : positionOf(src_.size() - 1);
+    // a string's lexeme starts after its opening quote
+    return positionOf(offset_[i] - (type(i) == TokenType::String ? 1 : 0));
+}
+
+size_t TokenBuffer::bytesUsed() const {
+    return size() * (2 + 2 * sizeof(std::uint32_t)) + newlines_.size() * sizeof(std::uint32_t);
+}
+
+// ------------ TokenCursor ------------
+TokenPos TokenCursor::position(const Token& t) const {
+    if (t.type == TokenType::EndOfFile) return buf_.position(buf_.size());
+    const auto off = static_cast<size_t>(t.lexeme.data() - buf_.source().data());
+    return buf_.positionOf(off - (t.type == TokenType::String ? 1 : 0));
+}
@@ -0,0 +1,66 @@
+// TokenBuffer.h
+// A whole file's tokens as parallel arrays: kind, sub-kind, 32-bit start
+// offset and 32-bit length, 10 bytes a token instead of a 32-byte Token.
+// Line/col are not stored; position() finds them in an index of newline
+// offsets when a diagnostic or the AST needs one (counting codepoints back
+// to the line start only if the source is not pure ASCII).
+//
+// The buffer views the source it was built from; keep that alive.
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "Token.h"
+#include "TokenSource.h"
+
+class TokenBuffer {
+public:
+    // Lex all of src (the last token is EndOfFile). False, leaving the
+    // buffer empty, if src is too large for 32-bit offsets.
+    bool build(std::string_view src);
+    void clear();
+
+    size_t size() const { return type_.size(); }
+    bool empty() const { return type_.empty(); }
+    TokenType type(size_t i) const { return static_cast<TokenType>(type_[i]); }
+    TokId id(size_t i) const { return static_cast<TokId>(id_[i]); }
+    std::string_view lexeme(size_t i) const { return { src_.data() + offset_[i], length_[i] }; }
+    std::uint32_t offset(size_t i) const { return offset_[i]; }   // of the lexeme
+    // Token i without line/col (0); past the end, the EndOfFile token
+    Token token(size_t i) const;
+    // line/col of token i as the Lexer reports them
+    TokenPos position(size_t i) const;
+    // line/col of a source byte, col in codepoints; a '\n' counts as col 0
+    // of the next line
+    TokenPos positionOf(size_t offset) const;
+
+    std::string_view source() const { return src_; }
+    size_t bytesUsed() const;   // filled part of the arrays + newline index
+
+private:
+    std::string_view src_;
+    std::vector<std::uint8_t> type_, id_;
+    std::vector<std::uint32_t> offset_, length_;
+    std::vector<std::uint32_t> newlines_;   // offset of every '\n', ascending
+    bool ascii_ = true;                     // byte columns are codepoint columns
+};
+
+// Walks a TokenBuffer by index as a TokenSource; any token ahead is one
+// array load away (peek).
+class TokenCursor final : public TokenSource {
+public:
+    explicit TokenCursor(const TokenBuffer& buf, size_t start = 0) : buf_(buf), next_(start) {}
+
+    Token nextToken() override { return buf_.token(next_ < buf_.size() ? next_++ : next_); }
+    TokenPos position(const Token& t) const override;
+
+    // k tokens past the one nextToken() returns next (0 = that one)
+    Token peek(size_t k = 0) const { return buf_.token(next_ + k); }
+    size_t index() const { return next_; }   // of the token nextToken() returns next
+    const TokenBuffer& buffer() const { return buf_; }
+
+private:
+    const TokenBuffer& buf_;
+    size_t next_;
+};
@@ -0,0 +1,127 @@
+#include "TokenCache.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include "Interner.h"
+#include "Lexer.h"
+
+std::uint64_t hashSource(std::string_view src) {
+    // FNV-1a over 8-byte words; the byte-wise loop cost more than the lexing we skip
+    std::uint64_t h = 0xcbf29ce484222325ull ^ src.size();
+    size_t i = 0;
+    for (; i + 8 <= src.size(); i += 8) {
+        std::uint64_t w;
+        std::memcpy(&w, src.data() + i, 8);
+        h = (h ^ w) * 0x100000001b3ull;
+        h ^= h >> 29;
+    }
+    for (; i < src.size(); ++i) { h ^= static_cast<unsigned char>(src[i]); h *= 0x100000001b3ull; }
+    return h;
+}
+
+bool writeTokenCache(const std::string& path, std::string_view src) {
+    if (src.size() > 0xFFFFFFFFu) return false;
+    std::vector<TokenRecord> records;
+    records.reserve(src.size() / 4 + 1);
+    Interner lexemes;
+    Lexer lex(src);
+    for (;;) {
+        Token t = lex.nextToken();
+        TokenRecord r{};
+        r.type = static_cast<std::uint8_t>(t.type);
+        r.id = static_cast<std::uint8_t>(t.id);
+        r.lexeme = lexemes.intern(t.lexeme);
+        // EOF has no lexeme in the buffer
+        r.offset = t.lexeme.data() ? static_cast<std::uint32_t>(t.lexeme.data() - src.data())
+                                   : static_cast<std::uint32_t>(src.size());
+        const TokenPos pos = lex.position(t);   // codepoint columns, so readers need no source
+        r.line = pos.line;
+        r.col = pos.col;
+        records.push_back(r);
+        if (t.type == TokenType::EndOfFile) break;
+    }
+
+    std::vector<std::uint32_t> starts(lexemes.size() + 1);
+    std::string pool;
+    for (Interner::Id i = 0; i < lexemes.size(); ++i) {
+        starts[i] = static_cast<std::uint32_t>(pool.size());
+        pool += lexemes.name(i);
+    }
+    starts[lexemes.size()] = static_cast<std::uint32_t>(pool.size());
+
+    TokenCacheHeader h{};
+    std::memcpy(h.magic, kTokenCacheMagic, sizeof h.magic);
+    h.version = kTokenCacheVersion;
+    h.recordSize = sizeof(TokenRecord);
+    h.sourceHash = hashSource(src);
+    h.sourceSize = src.size();
+    h.tokenCount = static_cast<std::uint32_t>(records.size());
+    h.lexemeCount = static_cast<std::uint32_t>(lexemes.size());
+    h.poolSize = static_cast<std::uint32_t>(pool.size());
+
+    // a reader never sees a half-written cache
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        out.write(reinterpret_cast<const char*>(&h), sizeof h);
+        out.write(reinterpret_cast<const char*>(records.data()),
+                  static_cast<std::streamsize>(records.size() * sizeof(TokenRecord)));
+        out.write(reinterpret_cast<const char*>(starts.data()),
+                  static_cast<std::streamsize>(starts.size() * sizeof(std::uint32_t)));
+        out.write(pool.data(), static_cast<std::streamsize>(pool.size()));
+        if (!out.flush()) { std::remove(tmp.c_str()); return false; }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) { std::remove(tmp.c_str()); return false; }
+    return true;
+}
+
+bool TokenCacheReader::open(const std::string& path, std::uint64_t sourceHash, std::uint64_t sourceSize) {
+    count_ = next_ = 0;
+    if (!file_.open(path) || file_.size() < sizeof(TokenCacheHeader)) return false;
+    TokenCacheHeader h;
+    std::memcpy(&h, file_.data(), sizeof h);
+    if (std::memcmp(h.magic, kTokenCacheMagic, sizeof h.magic) != 0 ||
+        h.version != kTokenCacheVersion || h.recordSize != sizeof(TokenRecord) ||
+        h.sourceHash != sourceHash || h.sourceSize != sourceSize || h.tokenCount == 0)
+        return false;
+    const size_t need = sizeof h + size_t{h.tokenCount} * sizeof(TokenRecord) +
+                        (size_t{h.lexemeCount} + 1) * sizeof(std::uint32_t) + h.poolSize;
+    if (file_.size() != need) return false;
+
+    records_ = file_.data() + sizeof h;
+    starts_ = records_ + size_t{h.tokenCount} * sizeof(TokenRecord);
+    pool_ = starts_ + (size_t{h.lexemeCount} + 1) * sizeof(std::uint32_t);
+    count_ = h.tokenCount;
+
+    // validate once so nextToken() needs no checks
+    std::uint32_t prev = 0;
+    for (std::uint32_t i = 0; i <= h.lexemeCount; ++i) {
+        std::uint32_t s;
+        std::memcpy(&s, starts_ + i * sizeof s, sizeof s);
+        if (s < prev || s > h.poolSize) return false;
+        prev = s;
+    }
+    for (size_t i = 0; i < count_; ++i) {
+        TokenRecord r;
+        std::memcpy(&r, records_ + i * sizeof r, sizeof r);
+        if (r.type > static_cast<std::uint8_t>(TokenType::EndOfFile) ||
+            r.id >= static_cast<std::uint8_t>(TokId::Count) || r.lexeme >= h.lexemeCount)
+            return false;
+    }
+    TokenRecord last;
+    std::memcpy(&last, records_ + (count_ - 1) * sizeof last, sizeof last);
+    return last.type == static_cast<std::uint8_t>(TokenType::EndOfFile);
+}
+
+Token TokenCacheReader::nextToken() {
+    TokenRecord r;
+    std::memcpy(&r, records_ + next_ * sizeof r, sizeof r);
+    if (next_ + 1 < count_) ++next_;   // EndOfFile repeats
+    std::uint32_t b, e;
+    std::memcpy(&b, starts_ + size_t{r.lexeme} * sizeof b, sizeof b);
+    std::memcpy(&e, starts_ + (size_t{r.lexeme} + 1) * sizeof e, sizeof e);
+    return { static_cast<TokenType>(r.type), static_cast<TokId>(r.id),
+             std::string_view(pool_ + b, e - b), r.line, r.col };
+}
@@ -0,0 +1,63 @@
+// TokenCache.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "MappedFile.h"
+#include "TokenSource.h"
+
+// On-disk token stream of one source file, so unchanged files skip the
+// Lexer. Layout (little-endian, 4-byte aligned):
+//   TokenCacheHeader
+//   TokenRecord[tokenCount]          the last one is EndOfFile
+//   uint32_t lexemeStart[lexemeCount + 1]   offsets into the pool
+//   char pool[poolSize]              each distinct lexeme once
+inline constexpr char kTokenCacheMagic[8] = { 'R', '2', '5', 'F', 'T', 'O', 'K', '\0' };
+inline constexpr std::uint32_t kTokenCacheVersion = 3;   // 2: token start positions, 3: codepoint columns
+
+struct TokenCacheHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t recordSize;     // sizeof(TokenRecord)
+    std::uint64_t sourceHash;     // hashSource() of the file it was built from
+    std::uint64_t sourceSize;
+    std::uint32_t tokenCount;
+    std::uint32_t lexemeCount;
+    std::uint32_t poolSize;
+    std::uint32_t reserved;
+};
+
+struct TokenRecord {
+    std::uint8_t type;            // TokenType
+    std::uint8_t id;              // TokId
+    std::uint16_t reserved;
+    std::uint32_t lexeme;         // index into lexemeStart
+    std::uint32_t offset;         // source byte offset of the lexeme
+    std::uint32_t line, col;      // token start, as the Lexer reported it
+};
+static_assert(sizeof(TokenCacheHeader) == 48 && sizeof(TokenRecord) == 20, "on-disk layout");
+
+// word-at-a-time FNV-1a over the whole source
+std::uint64_t hashSource(std::string_view src);
+
+// Lex src and write its cache to path (via a temp file + rename). False if
+// it can't be written or src is too large for 32-bit offsets.
+bool writeTokenCache(const std::string& path, std::string_view src);
+
+// Serves nextToken() straight from a mapped cache file.
+class TokenCacheReader final : public TokenSource {
+public:
+    // False if the file is missing, malformed, or not built from a source
+    // with this hash and size (i.e. stale).
+    bool open(const std::string& path, std::uint64_t sourceHash, std::uint64_t sourceSize);
+    size_t tokenCount() const { return count_; }
+    Token nextToken() override;
+
+private:
+    MappedFile file_;
+    const char* records_ = nullptr;
+    const char* starts_ = nullptr;
+    const char* pool_ = nullptr;
+    size_t count_ = 0, next_ = 0;
+};
@@ -0,0 +1,15 @@
+// TokenSource.h
+#pragma once
+#include "Token.h"
+
+// What the Parser reads tokens from: the Lexer, a replay of a cached token
+// stream (TokenCache.h) or a walk over a TokenBuffer (TokenBuffer.h).
+// After the last token, EndOfFile repeats.
+class TokenSource {
+public:
+    virtual ~TokenSource() = default;
+    virtual Token nextToken() = 0;
+    // where `t` (a token from this source) starts; only diagnostics and the
+    // AST ask, so sources that find it expensive compute it here
+    virtual TokenPos position(const Token& t) const { return { t.line, t.col }; }
+};
@@ -0,0 +1,77 @@
+// Utf8.cpp
+#include "Utf8.h"
+#include <algorithm>
+#include "CharScan.h"
+
+namespace utf8 {
+
+size_t sequenceLength(const char* p, const char* end) {
+    const auto b = [&](size_t i) { return static_cast<unsigned char>(p[i]); };
+    const auto cont = [](unsigned char c) { return (c & 0xC0) == 0x80; };
+    const unsigned char c0 = b(0);
+    if (c0 < 0x80) return 1;
+    const size_t left = static_cast<size_t>(end - p);
+    if (c0 >= 0xC2 && c0 <= 0xDF) return left >= 2 && cont(b(1)) ? 2 : 0;
+    // the second byte's range rules out overlong forms, surrogates and > U+10FFFF
+    unsigned char lo = 0x80, hi = 0xBF;
+    if (c0 >= 0xE0 && c0 <= 0xEF) {
+        if (c0 == 0xE0) lo = 0xA0;
+        if (c0 == 0xED) hi = 0x9F;
+        return left >= 3 && b(1) >= lo && b(1) <= hi && cont(b(2)) ? 3 : 0;
+    }
+    if (c0 >= 0xF0 && c0 <= 0xF4) {
+        if (c0 == 0xF0) lo = 0x90;
+        if (c0 == 0xF4) hi = 0x8F;
+        return left >= 4 && b(1) >= lo && b(1) <= hi && cont(b(2)) && cont(b(3)) ? 4 : 0;
+    }
+    return 0;   // a stray continuation byte, C0/C1 or F5..FF
+}
+
+size_t firstInvalid(std::string_view s) {
+    const char* p = s.data();
+    const char* end = p + s.size();
+    for (;;) {
+        p = scan::asciiEnd(p, end);
+        if (p == end) return npos;
+        const size_t n = sequenceLength(p, end);
+        if (!n) return static_cast<size_t>(p - s.data());
+        p += n;
+    }
+}
+
+size_t codepoints(const char* b, const char* e) {
+    size_t n = 0;
+    for (; b < e; ++b) n += (static_cast<unsigned char>(*b) & 0xC0) != 0x80;
+    return n;
+}
+
+TokenPos positionOf(std::string_view s, size_t offset) {
+    if (s.empty()) return { 1, 0 };
+    if (offset >= s.size()) offset = s.size() - 1;
+    const char* at = s.data() + offset;
+    const auto line = static_cast<std::uint32_t>(1 + std::count(s.data(), at, '\n'));
+    if (*at == '\n') return { line + 1, 0 };
+    const std::string_view before(s.data(), offset);
+    const size_t nl = before.rfind('\n');
+    const char* from = nl == std::string_view::npos ? s.data() : s.data() + nl + 1;
+    return { line, static_cast<std::uint32_t>(codepoints(from, at) + 1) };
+}
+
+TokenPos tokenPosition(const char* begin, const char* end, const Token& t) {
+    if (t.col <= 1 || begin == end) return { t.line, t.col };
+    // the byte the Lexer's column is of: EOF sits on the last byte, and a
+    // string's lexeme starts after its opening quote
+    const char* at = t.type == TokenType::EndOfFile ? end - 1
+                   : t.lexeme.data() - (t.type == TokenType::String ? 1 : 0);
+    const size_t back = t.col - 1;   // bytes from the line start
+    const char* from = static_cast<size_t>(at - begin) < back ? begin : at - back;
+    const size_t bytes = static_cast<size_t>(at - from);
+    return { t.line, static_cast<std::uint32_t>(t.col - (bytes - codepoints(from, at))) };
+}
+
+std::string errorMessage(TokenPos pos) {
+    return "Lexical error: invalid UTF-8 at line " + std::to_string(pos.line) +
+           ", col " + std::to_string(pos.col);
+}
+
+} // namespace utf8
@@ -0,0 +1,41 @@
+// Utf8.h
+// UTF-8 checks for the Lexer and the drivers. Sources are validated once up
+// front (ASCII runs are skipped a SIMD block at a time, CharScan.h); the
+// Lexer keeps counting columns in bytes, and only a source with non-ASCII
+// bytes pays for turning one into a codepoint column, when a position is
+// actually asked for.
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "Token.h"
+
+namespace utf8 {
+
+inline constexpr size_t npos = static_cast<size_t>(-1);
+
+// byte length of the well-formed sequence at p (< end), 0 if there is none:
+// no overlong forms, surrogates or codepoints past U+10FFFF
+size_t sequenceLength(const char* p, const char* end);
+
+// offset of the first byte that is not part of a well-formed sequence, npos
+// if all of s is valid UTF-8
+size_t firstInvalid(std::string_view s);
+
+// codepoints in [b, e): the bytes that are not 10xxxxxx continuations
+size_t codepoints(const char* b, const char* e);
+
+// line/col of s[offset] as the Lexer counts lines, with col in codepoints;
+// a '\n' counts as col 0 of the next line
+TokenPos positionOf(std::string_view s, size_t offset);
+
+// a Lexer token's position with its byte column turned into codepoints;
+// [begin, end) is the buffer that Lexer ran over. A line that starts before
+// begin keeps the column the Lexer started from (Lexer(source, line, col)).
+TokenPos tokenPosition(const char* begin, const char* end, const Token& t);
+
+// "Lexical error: invalid UTF-8 at line L, col C"
+std::string errorMessage(TokenPos pos);
+
+} // namespace utf8
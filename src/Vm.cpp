@@ -0,0 +1,201 @@
+// Vm.cpp
+#include "Vm.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define RAT25F_THREADED 1
+#endif
+
+namespace {
+
+// integer arithmetic wraps (two's complement) instead of being UB
+std::int64_t wrap(std::uint64_t v) { return static_cast<std::int64_t>(v); }
+std::uint64_t bits(std::int64_t v) { return static_cast<std::uint64_t>(v); }
+
+void putInt(std::ostream& out, std::int64_t v) {
+    char buf[24];
+    char* e = std::to_chars(buf, buf + sizeof buf, v).ptr;
+    *e++ = '\n';
+    out.write(buf, e - buf);
+}
+
+// shortest round-trip form, always with a '.' (or exponent) so it reads as real
+void putReal(std::ostream& out, double v) {
+    char buf[40];
+    char* e = std::to_chars(buf, buf + sizeof buf - 3, v).ptr;
+    if (std::memchr(buf, '.', e - buf) == nullptr && std::memchr(buf, 'e', e - buf) == nullptr &&
+        std::memchr(buf, 'n', e - buf) == nullptr) {   // not inf / nan
+        *e++ = '.';
+        *e++ = '0';
+    }
+    *e++ = '\n';
+    out.write(buf, e - buf);
+}
+
+[[noreturn]] void runtimeError(const std::string& what, const BcFunction& fn, size_t pc) {
+    throw std::runtime_error("Runtime error: " + what + " at line " + std::to_string(fn.lines[pc]));
+}
+
+} // namespace
+
+void Vm::run(std::istream& in, std::ostream& out) {
+    const BcFunction* fn = &mod_.functions.at(mod_.entry);
+    globals_.assign(mod_.globals.size(), Value{});
+    frames_.clear();
+    regs_.assign(std::max<size_t>(fn->frameSize, 4096), Value{});
+    if (!fn->consts.empty()) std::memcpy(&regs_[fn->locals], fn->consts.data(), fn->consts.size() * sizeof(Value));
+
+    size_t base = 0;
+    Value* r = regs_.data();
+    Value* g = globals_.data();
+    const Insn* code = fn->code.data();
+    const Insn* pc = code;
+
+    // by value: a capture would keep pc / fn out of registers
+#define fail(what) runtimeError(what, *fn, static_cast<size_t>(pc - code))
+#define A r[pc->a]
+#define B r[pc->b]
+#define C r[pc->c]
+// braces, not do/while: DISPATCH() is `continue` in the switch loop
+#define JUMP_IF(cond) { if (cond) { pc = code + pc->c; DISPATCH(); } NEXT(); }
+
+#ifdef RAT25F_THREADED
+    // one handler address per opcode, in Op order
+    static const void* const kHandlers[] = {
+#define RAT25F_VM_HANDLER(name) &&op_##name,
+        RAT25F_OPCODES(RAT25F_VM_HANDLER)
+#undef RAT25F_VM_HANDLER
+    };
+    static_assert(sizeof kHandlers / sizeof *kHandlers == static_cast<size_t>(Op::Count));
+#define DISPATCH() goto* kHandlers[static_cast<size_t>(pc->op)]
+#define HANDLER(name) op_##name:
+    DISPATCH();
+#else
+#define DISPATCH() continue
+#define HANDLER(name) case Op::name:
+    for (;;) switch (pc->op) {
+#endif
+#define NEXT() { ++pc; DISPATCH(); }
+
+    HANDLER(Move)      A = B; NEXT();
+    HANDLER(IntToReal) A.r = static_cast<double>(B.i); NEXT();
+    HANDLER(LoadG)     A = g[pc->c]; NEXT();
+    HANDLER(StoreG)    g[pc->c] = A; NEXT();
+
+    HANDLER(AddI) A.i = wrap(bits(B.i) + bits(C.i)); NEXT();
+    HANDLER(SubI) A.i = wrap(bits(B.i) - bits(C.i)); NEXT();
+    HANDLER(MulI) A.i = wrap(bits(B.i) * bits(C.i)); NEXT();
+    HANDLER(DivI) {
+        const std::int64_t d = C.i;
+        if (d == 0) fail("integer division by zero");
+        A.i = d == -1 ? wrap(0 - bits(B.i)) : B.i / d;   // INT64_MIN / -1 wraps too
+        NEXT();
+    }
+    HANDLER(AddR) A.r = B.r + C.r; NEXT();
+    HANDLER(SubR) A.r = B.r - C.r; NEXT();
+    HANDLER(MulR) A.r = B.r * C.r; NEXT();
+    HANDLER(DivR) A.r = B.r / C.r; NEXT();
+    HANDLER(NegI) A.i = wrap(0 - bits(B.i)); NEXT();
+    HANDLER(NegR) A.r = -B.r; NEXT();
+
+    HANDLER(Jmp)   pc = code + pc->c; DISPATCH();
+    HANDLER(JLtI)  JUMP_IF(A.i < B.i);
+    HANDLER(JLeI)  JUMP_IF(A.i <= B.i);
+    HANDLER(JEqI)  JUMP_IF(A.i == B.i);
+    HANDLER(JNeI)  JUMP_IF(A.i != B.i);
+    HANDLER(JLtR)  JUMP_IF(A.r < B.r);
+    HANDLER(JLeR)  JUMP_IF(A.r <= B.r);
+    HANDLER(JEqR)  JUMP_IF(A.r == B.r);
+    HANDLER(JNeR)  JUMP_IF(A.r != B.r);
+    HANDLER(JNLtR) JUMP_IF(!(A.r < B.r));
+    HANDLER(JNLeR) JUMP_IF(!(A.r <= B.r));
+
+    HANDLER(Call) {
+        const BcFunction* callee = &mod_.functions[pc->c];
+        if (frames_.size() >= kMaxDepth) fail("call stack overflow");
+        const size_t to = base + fn->frameSize;
+        if (to + callee->frameSize > regs_.size()) {
+            regs_.resize(std::max(regs_.size() * 2, to + callee->frameSize));
+            r = regs_.data() + base;
+        }
+        Value* nr = regs_.data() + to;
+        std::memcpy(nr, &B, callee->params * sizeof(Value));
+        std::memset(nr + callee->params, 0, (callee->locals - callee->params) * sizeof(Value));
+        if (!callee->consts.empty())
+            std::memcpy(nr + callee->locals, callee->consts.data(), callee->consts.size() * sizeof(Value));
+        frames_.push_back({ fn, pc + 1, base, pc->a });
+        fn = callee;
+        base = to;
+        r = nr;
+        code = pc = fn->code.data();
+        DISPATCH();
+    }
+    HANDLER(Ret) {
+        const Value v = A;
+        const Frame f = frames_.back();
+        frames_.pop_back();
+        fn = f.fn;
+        base = f.base;
+        r = regs_.data() + base;
+        code = fn->code.data();
+        pc = f.ret;
+        r[f.dst] = v;
+        DISPATCH();
+    }
+    HANDLER(RetVoid) {
+        if (frames_.empty()) return;
+        const Frame f = frames_.back();
+        frames_.pop_back();
+        fn = f.fn;
+        base = f.base;
+        r = regs_.data() + base;
+        code = fn->code.data();
+        pc = f.ret;
+        DISPATCH();
+    }
+
+    HANDLER(PutI) putInt(out, A.i); NEXT();
+    HANDLER(PutR) putReal(out, A.r); NEXT();
+    HANDLER(PutB) out << (A.i ? "true\n" : "false\n"); NEXT();
+    HANDLER(PutS) {
+        const std::string& s = mod_.strings[pc->c];
+        out.write(s.data(), static_cast<std::streamsize>(s.size()));
+        out.put('\n');
+        NEXT();
+    }
+    HANDLER(GetI) {
+        if (!(in >> A.i)) fail("integer input expected");
+        NEXT();
+    }
+    HANDLER(GetR) {
+        if (!(in >> A.r)) fail("real input expected");
+        NEXT();
+    }
+    HANDLER(GetB) {
+        std::string word;
+        if (!(in >> word)) fail("boolean input expected");
+        if (word == "true" || word == "1")       A.i = 1;
+        else if (word == "false" || word == "0") A.i = 0;
+        else fail("boolean input expected, got '" + word + "'");
+        NEXT();
+    }
+
+#ifndef RAT25F_THREADED
+        case Op::Count: fail("bad opcode");
+    }
+#endif
+#undef fail
+#undef NEXT
+#undef HANDLER
+#undef DISPATCH
+#undef JUMP_IF
+#undef C
+#undef B
+#undef A
+}
@@ -0,0 +1,37 @@
+// Vm.h
+// Runs a compiled Module (Bytecode.h). The interpreter loop is threaded:
+// each handler jumps straight to the next instruction's handler through a
+// label table (GCC / Clang computed goto), so there is no central switch
+// branch to mispredict. Other compilers get the plain switch loop.
+//
+// Registers are untagged Values on one stack shared by all frames; a call
+// only moves the frame base.
+#pragma once
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+#include "Bytecode.h"
+
+class Vm {
+public:
+    static constexpr size_t kMaxDepth = 100000;   // nested calls before "call stack overflow"
+
+    explicit Vm(const Module& m) : mod_(m) {}
+
+    // executes the entry; get reads `in`, put writes one value per line to
+    // `out`. Throws std::runtime_error ("Runtime error: <what> at line L").
+    void run(std::istream& in, std::ostream& out);
+
+private:
+    struct Frame {
+        const BcFunction* fn;
+        const Insn* ret;       // caller's next instruction
+        size_t base;           // caller's frame base
+        std::uint16_t dst;     // caller's register for the result
+    };
+
+    const Module& mod_;
+    std::vector<Value> regs_;
+    std::vector<Value> globals_;
+    std::vector<Frame> frames_;
+};
@@ -0,0 +1,33 @@
+// WorkerPool.h
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Run fn(i) for every i in [0, count) on up to `threads` workers. Workers
+// pull the next index from one shared atomic counter, so uneven jobs
+// balance themselves. threads <= 1 runs inline on the calling thread.
+template <class Fn>
+void parallelFor(size_t count, unsigned threads, Fn&& fn) {
+    if (threads <= 1 || count <= 1) {
+        for (size_t i = 0; i < count; ++i) fn(i);
+        return;
+    }
+    std::atomic<size_t> next{0};
+    auto worker = [&] {
+        for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < count; ) fn(i);
+    };
+    const unsigned n = static_cast<unsigned>(std::min<size_t>(threads, count));
+    std::vector<std::thread> pool;
+    pool.reserve(n - 1);
+    for (unsigned t = 1; t < n; ++t) pool.emplace_back(worker);
+    worker();   // the caller is worker 0
+    for (auto& th : pool) th.join();
+}
+
+inline unsigned hardwareThreads() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n ? n : 1;
+}
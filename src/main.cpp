@@ -1,38 +1,253 @@
-#include <fstream>
+#include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
 #include <vector>
+#include "BinaryTrace.h"
+#include "Compiler.h"
+#include "Fold.h"
+#include "LL1Parser.h"
 #include "Lexer.h"
-#include "Parser.h"
+#include "MappedFile.h"
+#include "parser.h"
+#include "PipelinedLexer.h"
+#include "Profile.h"
+#include "Sink.h"
+#include "Server.h"
+#include "SplitParse.h"
+#include "StreamLexer.h"
+#include "TokenCache.h"
+#include "Utf8.h"
+#include "Vm.h"
+#include "WorkerPool.h"
 
-static int run_one(const std::string& inPath, const std::string& outPath,
-                   TraceConfig trace, ParserPolicy policy) {
-    std::ifstream fin(inPath);
-    if (!fin) { std::cerr << "Error: cannot open input file: " << inPath << "\n"; return 1; }
+// driver messages may come from several workers at once
+static void logLine(const std::string& msg) {
+    static std::mutex mu;
+    std::lock_guard<std::mutex> lock(mu);
+    std::cerr << msg << "\n";
+}
 
-    std::ofstream fout(outPath);
-    if (!fout) { std::cerr << "Error: cannot open output file: " << outPath << "\n"; return 1; }
+// Token source for one input with -c: <input>.tok if it was built from this
+// exact source, else rebuilt first; null if no cache can be written.
+static std::unique_ptr<TokenCacheReader> cachedTokens(const std::string& inPath, std::string_view src) {
+    const std::string cachePath = inPath + ".tok";
+    const std::uint64_t hash = hashSource(src);
+    auto reader = std::make_unique<TokenCacheReader>();
+    if (reader->open(cachePath, hash, src.size())) return reader;
+    if (writeTokenCache(cachePath, src) && reader->open(cachePath, hash, src.size())) return reader;
+    logLine("Warning: cannot use token cache " + cachePath + "; lexing " + inPath);
+    return nullptr;
+}
 
-    // redirect both cout and cerr to the output file
-    std::streambuf* coutBuf = std::cout.rdbuf(fout.rdbuf());
-    std::streambuf* cerrBuf = std::cerr.rdbuf(fout.rdbuf());
+// "-" is stdout; stdin runs flush every chunk so output keeps up with the input.
+// `binary`: a BinaryTraceSink whose token records point into `source`
+static std::shared_ptr<BufferedFileSink> openOutput(const std::string& outPath, size_t capacity,
+                                                    bool binary = false, std::string_view source = {}) {
+    if (binary) {
+        if (outPath == "-") return std::make_shared<BinaryTraceSink>(1, source, capacity);
+        return std::make_shared<BinaryTraceSink>(outPath, source, capacity);
+    }
+    if (outPath == "-") return std::make_shared<BufferedFileSink>(1, capacity);
+    return std::make_shared<BufferedFileSink>(outPath, capacity);
+}
 
+// one serial parse from `tokens`, errors and the verdict into the sink;
+// `table` runs the LL(1) backend (LL1Parser.h) instead of the Parser.
+// `warm`: a Parser already writing to `sink`, reset to `tokens` instead of
+// building one
+static int parseAndReport(TokenSource& tokens, const TraceConfig& trace, const ParserPolicy& policy,
+                          const std::shared_ptr<BufferedFileSink>& sink, bool table,
+                          Parser<FullTrace>* warm = nullptr) {
     int rc = 0;
     try {
-        Lexer lex(fin);
-        Parser parser(lex, trace, policy);
+        if (table) {
+            LL1Parser parser(tokens, trace, policy, sink);
+            parser.parse(StartSymbol::Program);
+            sink->emit("Parsing finished successfully.");
+            return 0;
+        }
+        std::optional<Parser<FullTrace>> own;
+        if (warm) warm->reset(tokens);
+        else      own.emplace(tokens, trace, policy, sink);
+        Parser<FullTrace>& parser = warm ? *warm : *own;
         parser.parse(StartSymbol::Program);
-        std::cout << "Parsing finished successfully.\n";
+        if (parser.diagnostics().empty()) {
+            sink->emit("Parsing finished successfully.");
+        } else {
+            for (const Diagnostic& d : parser.diagnostics()) sink->diagnostic(d);
+            if (parser.droppedDiagnostics())
+                sink->error("... and " + std::to_string(parser.droppedDiagnostics()) + " more error(s)");
+            rc = 1;
+        }
     } catch (const std::exception& e) {
-        std::cerr << e.what() << "\n";
+        sink->error(e.what());
         rc = 1;
     }
+    return rc;
+}
+
+// Input "-": stdin through a StreamLexer (fixed-size double-buffered reads),
+// so memory stays flat however much a producer pipes in. Always serial.
+static int parse_stdin(const std::string& outPath, const TraceConfig& trace, const ParserPolicy& policy,
+                       bool table, bool binary) {
+    auto sink = openOutput(outPath, StreamLexer::kChunkSize, binary);
+    if (!sink->ok()) { logLine("Error: cannot open output file: " + outPath); return 1; }
+    StreamLexer lex(0);
+    lex.setIdleHook([&] { sink->flush(); });
+    int rc = parseAndReport(lex, trace, policy, sink, table);
+    if (lex.invalidUtf8()) {
+        sink->error(utf8::errorMessage(*lex.invalidUtf8()));
+        rc = 1;
+    }
+    if (lex.readError()) {
+        sink->error("Error: reading standard input failed");
+        rc = 1;
+    }
+    sink->flush();
+    return rc;
+}
+
+enum class ProfileReport { None, Table, Json };
+
+// per-file options from the command line
+struct RunOptions {
+    unsigned splitThreads = 1;   // > 1: function definitions in parallel (SplitParse.h)
+    bool tokenCache = false;     // tokens from <input>.tok (TokenCache.h) instead of the Lexer
+    bool table = false;          // LL(1) backend (LL1Parser.h), always serial
+    bool pipeline = false;       // lex on a second thread (PipelinedLexer.h)
+    bool binaryTrace = false;    // output as records (BinaryTrace.h), always serial
+    // this file's rule/token counters to stderr afterwards (RAT25F_PROFILE
+    // builds; the caller runs jobs one at a time then)
+    ProfileReport profile = ProfileReport::None;
+};
+
+// What parse_one keeps from one file to the next on a worker thread: the
+// output sink (reopened per file, its buffer kept), the Lexer and the Parser
+// (reset, keeping their tables). The trace and policy are the run's, the
+// same for every file; -b still builds its own sink per file.
+struct WarmParse {
+    std::shared_ptr<BufferedFileSink> sink;
+    Lexer lex{ std::string_view{} };
+    std::optional<Parser<FullTrace>> parser;
+
+    // the sink for outPath; null if it cannot be opened
+    BufferedFileSink* open(const std::string& outPath, const TraceConfig& trace, const ParserPolicy& policy) {
+        if (!sink) {
+            sink = openOutput(outPath, BufferedFileSink::kDefaultCapacity);
+            // primed on the empty Lexer; reset() moves it to each file
+            parser.emplace(lex, trace, policy, sink);
+        } else if (outPath == "-") {
+            sink->reopen(1);
+        } else {
+            sink->reopen(outPath);
+        }
+        return sink->ok() ? sink.get() : nullptr;
+    }
+};
+
+// Self-contained per job (own Lexer, Parser, sink per worker thread), so jobs
+// can run in parallel.
+static int parse_one(const std::string& inPath, const std::string& outPath,
+                     const TraceConfig& trace, const ParserPolicy& policy, const RunOptions& opt) {
+    if (inPath == "-") return parse_stdin(outPath, trace, policy, opt.table, opt.binaryTrace);
+
+    MappedFile fin;
+    if (!fin.open(inPath)) { logLine("Error: cannot open input file: " + inPath); return 1; }
+
+    // a Lexer / Parser belongs to the thread that built it (Profile.h)
+    thread_local WarmParse warm;
+    std::shared_ptr<BufferedFileSink> sink;
+    if (opt.binaryTrace) sink = openOutput(outPath, BinaryTraceSink::kDefaultCapacity, true, fin.view());
+    else if (warm.open(outPath, trace, policy)) sink = warm.sink;
+    if (!sink || !sink->ok()) { logLine("Error: cannot open output file: " + outPath); return 1; }
+
+    // not a single token is trusted from a source that is not UTF-8
+    if (const size_t bad = utf8::firstInvalid(fin.view()); bad != utf8::npos) {
+        sink->error(utf8::errorMessage(utf8::positionOf(fin.view(), bad)));
+        sink->flush();
+        return 1;
+    }
+
+    // tokens, productions and errors all go through the sink (no cout/cerr redirection);
+    // semantic checks need the whole program in one symbol table and recovery
+    // keeps its diagnostics in the one Parser, so both parse serially (as
+    // does -b: split spans come back as text)
+    const bool splittable = !policy.semanticChecks && !policy.recover && !opt.tokenCache && !opt.table &&
+                            !opt.binaryTrace;
+    if (opt.splitThreads > 1 && splittable && parseProgramSplit(fin.view(), trace, policy, opt.splitThreads, *sink)) {
+        sink->emit("Parsing finished successfully.");
+        sink->flush();
+        return 0;
+    }
+
+    std::unique_ptr<TokenCacheReader> cached = opt.tokenCache ? cachedTokens(inPath, fin.view()) : nullptr;
+    std::unique_ptr<TokenSource> lex;
+    if (cached)            lex = std::move(cached);
+    else if (opt.pipeline) lex = std::make_unique<PipelinedLexer>(fin.view());
+    TokenSource* tokens = lex.get();
+    if (!tokens) {
+        warm.lex.reset(fin.view());
+        tokens = &warm.lex;
+    }
+    Parser<FullTrace>* parser = opt.binaryTrace || opt.table ? nullptr : &*warm.parser;
+    int rc = parseAndReport(*tokens, trace, policy, sink, opt.table, parser);
+    sink->flush();
+    return rc;
+}
 
-    std::cout.rdbuf(coutBuf);
-    std::cerr.rdbuf(cerrBuf);
+static int run_one(const std::string& inPath, const std::string& outPath,
+                   const TraceConfig& trace, const ParserPolicy& policy, const RunOptions& opt) {
+    if (opt.profile == ProfileReport::None) return parse_one(inPath, outPath, trace, policy, opt);
+    ProfileCounters before = profileSnapshot();
+    int rc = parse_one(inPath, outPath, trace, policy, opt);
+    ProfileCounters delta = profileSnapshot();
+    delta -= before;
+    std::string report = formatProfile(delta, opt.profile == ProfileReport::Json, inPath);
+    report.pop_back();   // logLine adds the newline
+    logLine(report);
     return rc;
 }
 
+// --run: parse with semantic checks, compile to bytecode and execute;
+// get / put use stdin / stdout. fold = -O (Fold.h), its node count to stderr
+static int run_program(const std::string& inPath, bool fold) {
+    MappedFile fin;
+    if (!fin.open(inPath)) { std::cerr << "Error: cannot open input file: " << inPath << "\n"; return 1; }
+    if (const size_t bad = utf8::firstInvalid(fin.view()); bad != utf8::npos) {
+        std::cerr << utf8::errorMessage(utf8::positionOf(fin.view(), bad)) << "\n";
+        return 1;
+    }
+    try {
+        ParseResult ast;
+        {
+            Lexer lex(fin.view());
+            ParserPolicy policy;
+            policy.echoTokens = false;
+            policy.semanticChecks = true;
+            Parser<NoTrace> parser(lex, TraceConfig{}, policy, std::make_shared<NullSink>());
+            parser.parse(StartSymbol::Program, ast);
+        }
+        Module program = compileProgram(ast);
+        if (fold) {
+            // the unfolded compile above checked every branch the fold may drop
+            const FoldStats folded = foldConstants(ast);
+            std::cerr << "Folded: " << folded.removed() << " of " << folded.before << " AST nodes removed\n";
+            program = compileProgram(ast, &program);
+        }
+        std::ios::sync_with_stdio(false);
+        Vm(program).run(std::cin, std::cout);
+        std::cout.flush();
+    } catch (const std::exception& e) {
+        std::cout.flush();
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
 int main(int argc, char** argv) {
     // Trace/policy knobs (match prof’s sample)
     TraceConfig trace;
@@ -46,33 +261,119 @@ int main(int argc, char** argv) {
     policy.lenientKeywords = true;     // allow id/kw interop on textual match
     policy.allowStringPrimary = true;  // allow strings as primary
 
-    // No-arg mode: run your 4 test cases automatically
-    if (argc == 1) {
-        std::vector<std::pair<std::string,std::string>> jobs = {
+    // Options (0 = one worker per hardware thread); the rest are paths
+    //   -j N  files in parallel
+    //   -p N  function definitions of each file in parallel
+    //   -s    semantic checks (undeclared / duplicate names, call arity)
+    //   -r    recover from errors and report all of them
+    //   -c    reuse <input>.tok token caches, rebuilt when the input changes
+    //   -P F  per-rule / per-token-kind profile after each file, F = table | json
+    //         (needs a -DRAT25F_PROFILE build)
+    //   -T    with -P, also time every rule with the cycle counter (slower)
+    //   -L    table-driven LL(1) parse (LL1Parser.h); no -s / -r, never split
+    //   --pipeline  lex on a second thread, feeding the parser in batches
+    //   -b    write the trace as binary records (BinaryTrace.h); tools/tracedump decodes it
+    //   --run F   compile program F and execute it (Vm.h), get/put on stdin/stdout
+    //   -O    with --run, fold constants and dead branches first (Fold.h)
+    // An input of "-" streams stdin (always serial, no -c); an output of "-" is stdout.
+    //   --server  answer parse requests on stdin until it ends (Server.h), -j N at a time
+    unsigned jobsN = 1;
+    RunOptions opt;
+    bool timeRules = false;
+    bool server = false;
+    std::string runPath;
+    bool fold = false;
+    std::vector<std::string> args;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "-s") {
+            policy.semanticChecks = true;
+        } else if (a == "-r") {
+            policy.recover = true;
+        } else if (a == "-c") {
+            opt.tokenCache = true;
+        } else if (a == "-L") {
+            opt.table = true;
+        } else if (a == "-b") {
+            opt.binaryTrace = true;
+        } else if (a == "--pipeline") {
+            opt.pipeline = true;
+        } else if (a == "-O") {
+            fold = true;
+        } else if (a == "--run") {
+            runPath = i + 1 < argc ? argv[++i] : "";
+            if (runPath.empty()) { std::cerr << "Error: --run needs a program file\n"; return 1; }
+        } else if (a == "--server") {
+            server = true;
+        } else if (a == "-T") {
+            timeRules = true;
+        } else if (a == "-P") {
+            std::string f = i + 1 < argc ? argv[++i] : "";
+            if (f != "table" && f != "json") { std::cerr << "Error: bad -P value: " << f << "\n"; return 1; }
+            opt.profile = f == "json" ? ProfileReport::Json : ProfileReport::Table;
+        } else if (a.rfind("-j", 0) == 0 || a.rfind("-p", 0) == 0) {
+            std::string n = (a.size() > 2) ? a.substr(2) : (i + 1 < argc ? argv[++i] : "");
+            char* end = nullptr;
+            unsigned long v = std::strtoul(n.c_str(), &end, 10);
+            if (n.empty() || *end != '\0') { std::cerr << "Error: bad " << a.substr(0, 2) << " value: " << n << "\n"; return 1; }
+            (a[1] == 'j' ? jobsN : opt.splitThreads) = v ? static_cast<unsigned>(v) : hardwareThreads();
+        } else {
+            args.push_back(a);
+        }
+    }
+
+    if (opt.table && (policy.semanticChecks || policy.recover || server)) {
+        std::cerr << "Error: -L parses only; it cannot be combined with -s, -r or --server\n";
+        return 1;
+    }
+
+    if (!runPath.empty()) return run_program(runPath, fold);
+
+    if (server) {
+        std::ios::sync_with_stdio(false);
+        return runServer(std::cin, std::cout, trace, policy, jobsN);
+    }
+
+    std::vector<std::pair<std::string,std::string>> jobs;
+    const bool testMode = args.empty();
+    if (testMode) {
+        // No-arg mode: run your 4 test cases automatically
+        jobs = {
             {"tests/test0.rat25f", "tests/output0.txt"},
             {"tests/test1.rat25f", "tests/output1.txt"},
             {"tests/test2.rat25f", "tests/output2.txt"},
             {"tests/test3.rat25f", "tests/output3.txt"},
         };
-        int rc = 0;
-        for (auto& [inP, outP] : jobs) {
-            std::cerr << "==> " << inP << " -> " << outP << "\n";
-            rc |= run_one(inP, outP, trace, policy);
-        }
-        return rc;
-    }
-
-    // Pair mode: <in1> <out1> [<in2> <out2> ...]
-    if ((argc < 3) || (argc % 2 == 0)) {
+    } else if (args.size() % 2 != 0) {
+        // Pair mode: <in1> <out1> [<in2> <out2> ...]
         std::cerr << "Usage: " << argv[0]
-                  << " <input1> <output1> [<input2> <output2> ...]\n";
+                  << " [-j N] [-p N] [-s] [-r] [-c] [-L] [-b] [--pipeline] [-P table|json [-T]] [--server] [--run <program> [-O]] <input1> <output1> [<input2> <output2> ...]\n";
         std::cerr << "Or run with no args to process tests/test{0..3}.rat25f.\n";
         return 1;
+    } else {
+        for (size_t i = 0; i + 1 < args.size(); i += 2) jobs.emplace_back(args[i], args[i+1]);
+        size_t fromStdin = 0, toStdout = 0;
+        for (const auto& [inP, outP] : jobs) { fromStdin += inP == "-"; toStdout += outP == "-"; }
+        if (fromStdin > 1 || toStdout > 1) { std::cerr << "Error: '-' can be used once as input and once as output\n"; return 1; }
     }
 
-    int rc = 0;
-    for (int i = 1; i + 1 < argc; i += 2) {
-        rc |= run_one(argv[i], argv[i+1], trace, policy);
+    if (opt.profile != ProfileReport::None) {
+        if (!kProfileEnabled) {
+            std::cerr << "Warning: -P ignored; build with -DRAT25F_PROFILE to enable profiling\n";
+            opt.profile = ProfileReport::None;
+        }
+        jobsN = 1;   // each report is the counter delta of one file
+        setProfileRuleTiming(timeRules);
     }
+
+    std::vector<int> results(jobs.size(), 0);
+    parallelFor(jobs.size(), jobsN, [&](size_t i) {
+        const auto& [inP, outP] = jobs[i];
+        if (testMode) logLine("==> " + inP + " -> " + outP);
+        results[i] = run_one(inP, outP, trace, policy, opt);
+    });
+
+    int rc = 0;
+    for (int r : results) rc |= r;
     return rc;
 }
@@ -1,514 +1,983 @@
 // Parser.cpp
-#include "Parser.h"
-#include <iostream>
-#include <stdexcept>
+#include "parser.h"
+#include <charconv>
+#include <limits>
 
-// ------------ pretty token name ------------
-const char* prettyTokenKind(TokenType t) {
-    switch (t) {
-        case TokenType::Identifier: return "Identifier";
-        case TokenType::Keyword:    return "Keyword";
-        case TokenType::Integer:    return "Integer";
-        case TokenType::Real:       return "Real";
-        case TokenType::Operator:   return "Operator";
-        case TokenType::Separator:  return "Separator";
-        case TokenType::String:     return "String";
-        case TokenType::Unknown:    return "Unknown";
-        case TokenType::EndOfFile:  return "EOF";
-    }
-    return "Unknown";
+// per-rule counters/timing; nothing without RAT25F_PROFILE (Profile.h)
+#define PROFILE_RULE(r) RAT25F_PROFILE_RULE(*prof_, Rule::r)
+
+// ------------ trace filter ------------
+static inline bool contains(std::string_view s, std::string_view sub) {
+    return s.find(sub) != std::string_view::npos;
 }
 
-void ConsoleSink::emit(std::string_view line) {
-    std::cout << line << "\n";
+// Resolve every TraceConfig switch once per production; prod() is then one load.
+TraceFilter::TraceFilter(const TraceConfig& trace) {
+    for (size_t i = 0; i < kProdCount; ++i) {
+        const ProdInfo& info = kProdInfo[i];
+        std::string_view text = info.text;
+        bool on = trace.master;
+        // 선택 규칙만 출력(비워두면 전부 허용)
+        if (!trace.enabled.empty() && trace.enabled.count(info.rule) == 0) on = false;
+        // 자동 필터: ε / Opt / 상위 스캐폴딩
+        if (trace.hideEpsilon && contains(text, "ε")) on = false;
+        if (trace.hideOpt && contains(text, "Opt ")) on = false;
+        if (trace.hideScaffolding &&
+            (contains(text, "Rat25F") || contains(text, "Statement List"))) on = false;
+        show[i] = on;
+    }
+    relop = trace.master && trace.enabled.count(Rule::Relop) != 0;
 }
 
-struct ParseError : std::runtime_error { using std::runtime_error::runtime_error; };
+// ------------ FIRST sets (TokId masks) ------------
+// keyword/separator starts of <Statement>; Identifier (Assign) is checked by type
+static constexpr std::uint64_t kStatementFirst =
+    tokSet(TokId::LBrace, TokId::If, TokId::Return, TokId::Put, TokId::Get, TokId::While);
+static constexpr std::uint64_t kQualifier = tokSet(TokId::Integer, TokId::Boolean, TokId::Real);
+static constexpr std::uint64_t kRelop =
+    tokSet(TokId::EqEq, TokId::NotEq, TokId::Greater, TokId::Less, TokId::LessEq, TokId::GreaterEq);
 
-// ------------ small utils ------------
-static inline bool contains(std::string_view s, std::string_view sub) {
-    return s.find(sub) != std::string_view::npos;
+// ------------ Parser impl ------------
+template <class TracePolicy>
+Parser<TracePolicy>::Parser(TokenSource& lex, const TraceConfig& trace, ParserPolicy policy,
+                            std::shared_ptr<ProductionSink> sink)
+    : lex_(&lex), filter_(trace), policy_(std::move(policy)), sink_(std::move(sink)) {
+    if (policy_.recover) diags_.reserve(policy_.maxDiagnostics);
+    tok_ = lex_->nextToken();   // not advance(): nothing is consumed yet
+}
+
+template <class TracePolicy>
+void Parser<TracePolicy>::reset(TokenSource& lex) {
+    lex_ = &lex;
+    depth_ = 0;
+    ast_ = nullptr;
+    diags_.clear();
+    dropped_ = 0;
+    if (policy_.recover) diags_.reserve(policy_.maxDiagnostics);
+    tok_ = lex_->nextToken();
+}
+
+template <class TracePolicy>
+void Parser<TracePolicy>::reset(TokenSource& lex, const ParserPolicy& policy) {
+    policy_ = policy;
+    reset(lex);
+}
+
+template <class TracePolicy>
+void Parser<TracePolicy>::parse(StartSymbol start) { parseStart(start); }
+
+template <class TracePolicy>
+void Parser<TracePolicy>::parse(StartSymbol start, ParseResult& out) {
+    out.clear();
+    ast_ = &out;
+    try {
+        out.root = parseStart(start);
+    } catch (...) {
+        ast_ = nullptr;
+        throw;
+    }
+    ast_ = nullptr;
 }
 
-// ------------ Parser impl ------------
-Parser::Parser(Lexer& lex, TraceConfig trace, ParserPolicy policy,
-               std::shared_ptr<ProductionSink> sink)
-    : lex_(lex), trace_(std::move(trace)), policy_(std::move(policy)), sink_(std::move(sink)) {
-    advance();
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseStart(StartSymbol start) {
+    checking_ = policy_.semanticChecks && start == StartSymbol::Program;
+    names_ = ast_ ? &ast_->names : checking_ ? &ownNames_ : nullptr;
+    if (checking_) {
+        if (!ast_) ownNames_.clear();
+        symbols_.reset();
+    }
+    diags_.clear();
+    dropped_ = 0;
+    return settled([&]() -> NodeId {
+        switch (start) {
+            case StartSymbol::Program:    return parseRat25F();
+            case StartSymbol::Statement:  return parseStatement();
+            case StartSymbol::Expression: return parseExpression();
+        }
+        return 0;
+    });
 }
 
-void Parser::parse(StartSymbol start) {
-    switch (start) {
-        case StartSymbol::Program:    parseRat25F();    break;
-        case StartSymbol::Statement:  parseStatement(); break;
-        case StartSymbol::Expression: parseExpression(); break;
+template <class TracePolicy>
+void Parser<TracePolicy>::parseFunctionUnit() {
+    settled([&] {
+        parseFunction();
+        skipBannerStrings();
+        if (tok_.type != TokenType::EndOfFile) errorHere(DiagCode::ExpectedEndOfSegment);
+    });
+}
+
+// same steps parseRat25F takes once <Function Definitions Prime> runs out
+template <class TracePolicy>
+void Parser<TracePolicy>::parseProgramTail() {
+    settled([&] {
+        skipBannerStrings();
+        prod(Prod::FuncDefsPrimeEps);
+        skipBannerStrings();
+        parseOptDeclarationList();
+        skipBannerStrings();
+        parseStatementList();
+    });
+}
+
+// A ParseError's text points into the lexer's input (or the parse's names),
+// which may be gone by the time a caller asks what() it was.
+template <class TracePolicy>
+template <class F>
+auto Parser<TracePolicy>::settled(F&& parseFn) {
+    try {
+        return parseFn();
+    } catch (ParseError& e) {
+        e.settle();
+        throw;
     }
 }
 
-void Parser::advance() { tok_ = lex_.nextToken(); }
+template <class TracePolicy>
+void Parser<TracePolicy>::advance() {
+    RAT25F_PROFILE_TOKEN(*prof_);
+    tok_ = lex_->nextToken();
+}
+
+template <class TracePolicy>
+bool Parser<TracePolicy>::isKw(TokId id) const {
+    if (tok_.id != id) return false;
+    // lenient: an Identifier carrying the keyword's ID also counts
+    return tok_.type == TokenType::Keyword
+        || (policy_.lenientKeywords && tok_.type == TokenType::Identifier);
+}
+template <class TracePolicy>
+bool Parser<TracePolicy>::isOp(TokId id) const { return tok_.type == TokenType::Operator  && tok_.id == id; }
+template <class TracePolicy>
+bool Parser<TracePolicy>::isSep(TokId id) const { return tok_.type == TokenType::Separator && tok_.id == id; }
+template <class TracePolicy>
+bool Parser<TracePolicy>::inSet(std::uint64_t set) const { return (tokBit(tok_.id) & set) != 0; }
+template <class TracePolicy>
+bool Parser<TracePolicy>::isKwIn(std::uint64_t set) const {
+    if (!inSet(set)) return false;
+    return tok_.type == TokenType::Keyword
+        || (policy_.lenientKeywords && tok_.type == TokenType::Identifier);
+}
+// these IDs are only ever set on Keyword/Separator tokens, so the ID test is enough
+template <class TracePolicy>
+bool Parser<TracePolicy>::startsStatement() const { return inSet(kStatementFirst); }
+
+template <class TracePolicy>
+[[noreturn]] void Parser<TracePolicy>::errorHere(DiagCode code, TokId expected, std::uint32_t count) const {
+    const TokenPos pos = here();
+    throw ParseError({ code, expected, pos.line, pos.col, count, 0, tok_.lexeme });
+}
+
+template <class TracePolicy>
+void Parser<TracePolicy>::echoToken() {
+    if constexpr (TracePolicy::kEcho) {
+        if (!policy_.echoTokens) return;
+        if (tok_.type == TokenType::EndOfFile) return;
+        sink_->token(tok_);
+    }
+}
 
-bool Parser::isKw(const char* s) const {
-    if (!policy_.lenientKeywords) {
-        return (tok_.type == TokenType::Keyword) && (tok_.lexeme == s);
+template <class TracePolicy>
+void Parser<TracePolicy>::prod(Prod p) {
+    if constexpr (TracePolicy::kTrace) {
+        if (filter_.show[static_cast<size_t>(p)]) sink_->production(p);
     }
-    // lenient: Keyword 또는 Identifier여도 lexeme가 같으면 허용
-    if (tok_.type == TokenType::Keyword || tok_.type == TokenType::Identifier)
-        return tok_.lexeme == s;
-    return false;
 }
-bool Parser::isOp(const char* s) const { return tok_.type == TokenType::Operator  && tok_.lexeme == s; }
-bool Parser::isSep(const char* s) const { return tok_.type == TokenType::Separator && tok_.lexeme == s; }
 
-[[noreturn]] void Parser::errorHere(const std::string& msg) const {
-    throw ParseError("Syntax error: " + msg +
-                     " at line " + std::to_string(tok_.line) +
-                     ", col " + std::to_string(tok_.col) +
-                     " (near '" + tok_.lexeme + "')");
+// ------------ AST building ------------
+// every builder is a no-op returning 0 unless parse(start, result) attached ast_
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::node(NodeKind kind) {
+    if (!ast_) return 0;
+    const TokenPos pos = here();
+    return ast_->add(kind, pos.line, pos.col);
 }
 
-void Parser::echoToken() {
-    if (!policy_.echoTokens) return;
-    if (tok_.type == TokenType::EndOfFile) return;
-    std::cout << "Token: " << prettyTokenKind(tok_.type)
-              << " Lexeme: " << tok_.lexeme << "\n";
+template <class TracePolicy>
+void Parser<TracePolicy>::append(NodeList& list, NodeId n) {
+    if (n) list.append(*ast_, n);
 }
 
-void Parser::prod(Rule r, const char* text) {
-    if (!trace_.master) return;
+template <class TracePolicy>
+void Parser<TracePolicy>::retag(NodeId ids, NodeKind kind, TokId qualifier) {
+    for (NodeId n = ids; n; n = at(n).next) {
+        at(n).kind = kind;
+        at(n).op = qualifier;
+    }
+}
 
-    // 선택 규칙만 출력(비워두면 전부 허용)
-    if (!trace_.enabled.empty() && trace_.enabled.count(r) == 0)
-        return;
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::identNode(IdRole role) {
+    const TokenPos pos = checking_ ? here() : TokenPos{};
+    NodeId id = node(NodeKind::Ident);
+    std::uint32_t name = expectIdentifier();
+    if (id) at(id).a = name;
+    if (checking_) {
+        if (role == IdRole::Declare) declareVar(name, pos.line, pos.col);
+        else                         useVar(name, pos.line, pos.col);
+    }
+    return id;
+}
+
+// current Integer/Real/Bool/String token as a leaf, then consume it
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::literal(NodeKind kind) {
+    NodeId lit = node(kind);
+    if (lit) {
+        AstNode& n = at(lit);
+        const char* b = tok_.lexeme.data();
+        const char* e = b + tok_.lexeme.size();
+        switch (kind) {
+            case NodeKind::IntLit: {
+                std::int64_t v = 0;
+                if (std::from_chars(b, e, v).ec == std::errc::result_out_of_range)
+                    v = std::numeric_limits<std::int64_t>::max();
+                setIntValue(n, v);
+                break;
+            }
+            case NodeKind::RealLit: {
+                double v = 0;
+                std::from_chars(b, e, v);
+                setRealValue(n, v);
+                break;
+            }
+            case NodeKind::BoolLit:   n.op = tok_.id; break;
+            case NodeKind::StringLit: n.a = ast_->names.intern(tok_.lexeme); break;
+            default: break;
+        }
+    }
+    echoToken(); advance();
+    return lit;
+}
+
+// ------------ semantic checks ------------
+// Function bodies come before the global declarations, so a name a function
+// can't resolve locally is deferred until those are in (resolvePending).
+template <class TracePolicy>
+void Parser<TracePolicy>::semanticError(DiagCode code, std::uint32_t name, std::uint32_t line, std::uint32_t col,
+                                        std::uint32_t count, std::uint32_t got) {
+    const Diagnostic d{ code, TokId::None, line, col, count, got, names_->name(name) };
+    // nothing to resync after a semantic error; just note it and go on
+    if (policy_.recover) report(d);
+    else throw ParseError(d);
+}
+
+template <class TracePolicy>
+void Parser<TracePolicy>::declareVar(std::uint32_t name, std::uint32_t line, std::uint32_t col) {
+    if (!symbols_.declareVar(name, TokId::None, line, col))
+        semanticError(DiagCode::DuplicateDeclaration, name, line, col);
+}
+
+template <class TracePolicy>
+void Parser<TracePolicy>::useVar(std::uint32_t name, std::uint32_t line, std::uint32_t col) {
+    if (symbols_.findVar(name)) return;
+    if (symbols_.inFunction()) symbols_.defer({ name, 0, false, line, col });
+    else semanticError(DiagCode::UndeclaredIdentifier, name, line, col);
+}
+
+template <class TracePolicy>
+void Parser<TracePolicy>::useFunction(std::uint32_t name, std::uint32_t argc,
+                                      std::uint32_t line, std::uint32_t col) {
+    if (const SymbolTable::Func* f = symbols_.findFunction(name)) {
+        if (f->arity != argc)
+            semanticError(DiagCode::ArityMismatch, name, line, col, f->arity, argc);
+    } else if (symbols_.inFunction()) {
+        symbols_.defer({ name, argc, true, line, col });   // may be defined further down
+    } else {
+        semanticError(DiagCode::UndeclaredFunction, name, line, col);
+    }
+}
 
-    // 자동 필터: ε / Opt / 상위 스캐폴딩
-    if (trace_.hideEpsilon && contains(text, "ε")) return;
-    if (trace_.hideOpt && contains(text, "Opt ")) return;
-    if (trace_.hideScaffolding &&
-        (contains(text, "Rat25F") || contains(text, "Statement List"))) return;
+// every function and global is declared now; deferred uses must resolve
+template <class TracePolicy>
+void Parser<TracePolicy>::resolvePending() {
+    for (const SymbolTable::Use& u : symbols_.pending()) {
+        if (u.call) useFunction(u.name, u.arity, u.line, u.col);
+        else        useVar(u.name, u.line, u.col);
+    }
+    symbols_.pending().clear();
+}
+
+// ------------ error recovery ------------
+// With policy_.recover, statements, declarations and functions catch the
+// ParseError of anything inside them, record it and skip ahead to a token
+// the parse can go on from. Each of them consumes its first token before it
+// can fail, so the enclosing loops always make progress.
+template <class TracePolicy>
+template <class F>
+NodeId Parser<TracePolicy>::recoverable(Sync sync, F&& parseFn) {
+    if (!policy_.recover) return parseFn();
+    try {
+        return parseFn();
+    } catch (ParseError& e) {
+        report(e.diag);
+        synchronize(sync);
+        return 0;
+    }
+}
+
+template <class TracePolicy>
+void Parser<TracePolicy>::report(const Diagnostic& d) {
+    if (diags_.size() < policy_.maxDiagnostics) diags_.push_back(d);   // copies the text
+    else ++dropped_;   // capped: pathological input can't grow memory
+}
+
+// Panic mode: drop tokens (not echoed) up to a FOLLOW-set token.
+//   Statement    past ';' or a closed { } block; stop before '}', fi, while
+//   IfStatement  same, but the construct ends with its own fi
+//   Declaration  past ';'; stop before '{' '}'
+//   Function     past the closing '}' of the body
+// All of them stop before 'function' and end of input.
+template <class TracePolicy>
+void Parser<TracePolicy>::synchronize(Sync sync) {
+    int braces = 0;
+    int ifs = (sync == Sync::IfStatement) ? 1 : 0;
+    for (;;) {
+        if (tok_.type == TokenType::EndOfFile || isKw(TokId::Function)) return;
+        switch (sync) {
+            case Sync::Declaration:
+                if (isSep(TokId::LBrace) || isSep(TokId::RBrace)) return;
+                if (isSep(TokId::Semicolon)) { advance(); return; }
+                break;
+            case Sync::Function:
+                if (isSep(TokId::LBrace)) ++braces;
+                else if (isSep(TokId::RBrace) && (braces == 0 || --braces == 0)) { advance(); return; }
+                break;
+            case Sync::Statement:
+            case Sync::IfStatement:
+                if (braces == 0 && isSep(TokId::RBrace)) return;   // closes the enclosing block
+                if (braces == 0 && ifs == 0) {
+                    if (isSep(TokId::Semicolon)) { advance(); return; }
+                    if (isKw(TokId::Fi) || isKw(TokId::While)) return;
+                }
+                if (isSep(TokId::LBrace)) ++braces;
+                else if (isSep(TokId::RBrace)) { if (--braces == 0 && ifs == 0) { advance(); return; } }
+                else if (isKw(TokId::If)) ++ifs;
+                else if (isKw(TokId::Fi) && ifs > 0) { if (--ifs == 0 && braces == 0) { advance(); return; } }
+                break;
+        }
+        advance();
+    }
+}
 
-    sink_->emit(text);
+// ------------ nesting limit ------------
+template <class TracePolicy>
+Parser<TracePolicy>::NestingScope::NestingScope(Parser& p) : p_(p) {
+    if (p_.policy_.maxNesting && p_.depth_ >= p_.policy_.maxNesting)
+        p_.errorHere(DiagCode::NestingTooDeep, TokId::None, static_cast<std::uint32_t>(p_.policy_.maxNesting));
+    ++p_.depth_;
 }
 
 // ------------ expect ------------
-void Parser::expectIdentifier() {
-    if (tok_.type != TokenType::Identifier) errorHere("identifier expected");
+template <class TracePolicy>
+std::uint32_t Parser<TracePolicy>::expectIdentifier() {
+    if (tok_.type != TokenType::Identifier) errorHere(DiagCode::ExpectedIdentifier);
+    std::uint32_t name = names_ ? names_->intern(tok_.lexeme) : 0;
     echoToken(); advance();
+    return name;
 }
-void Parser::expectKw(const char* s) {
-    if (!isKw(s)) errorHere(std::string("'") + s + "' expected");
+template <class TracePolicy>
+void Parser<TracePolicy>::expectKw(TokId id) {
+    if (!isKw(id)) errorHere(DiagCode::ExpectedKeyword, id);
     echoToken(); advance();
 }
-void Parser::expectOp(const char* s) {
-    if (!isOp(s)) errorHere(std::string("operator '") + s + "' expected");
+template <class TracePolicy>
+void Parser<TracePolicy>::expectOp(TokId id) {
+    if (!isOp(id)) errorHere(DiagCode::ExpectedOperator, id);
     echoToken(); advance();
 }
-void Parser::expectSep(const char* s) {
-    if (!isSep(s)) errorHere(std::string("separator '") + s + "' expected");
+template <class TracePolicy>
+void Parser<TracePolicy>::expectSep(TokId id) {
+    if (!isSep(id)) errorHere(DiagCode::ExpectedSeparator, id);
     echoToken(); advance();
 }
 
 // =================== Grammar ===================
+// Each parse* returns the AST node it built (a list head for lists), or 0
+// when no ParseResult is attached. Tracing is independent of the AST.
 
 // <Rat25F> -> <Opt Function Definitions> <Opt Declaration List> <Statement List>
-void Parser::parseRat25F() {
-    prod(Rule::Rat25F, "<Rat25F> -> <Opt Function Definitions> <Opt Declaration List> <Statement List>");
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseRat25F() {
+    PROFILE_RULE(Rat25F);
+    NodeId prog = node(NodeKind::Program);
+    prod(Prod::Rat25F);
     skipBannerStrings();
-    parseOptFunctionDefinitions();
+    NodeId fns = parseOptFunctionDefinitions();
     skipBannerStrings();
-    parseOptDeclarationList();
+    NodeId decls = parseOptDeclarationList();
+    if (checking_) resolvePending();
     skipBannerStrings();
-    parseStatementList();
+    NodeId stmts = parseStatementList();
+    if (prog) { AstNode& n = at(prog); n.a = fns; n.b = decls; n.c = stmts; }
+    return prog;
 }
 
 
 // ----- Function defs -----
-void Parser::parseOptFunctionDefinitions() {
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseOptFunctionDefinitions() {
+    PROFILE_RULE(OptFuncDefs);
     skipBannerStrings();  // <== NEW (handles banners before the first function)
-    if (isKw("function")) {
-        prod(Rule::OptFuncDefs, "<Opt Function Definitions> -> <Function Definitions>");
-        parseFunctionDefinitions();
-    } else {
-        prod(Rule::OptFuncDefs, "<Opt Function Definitions> -> ε");
+    if (isKw(TokId::Function)) {
+        prod(Prod::OptFuncDefs);
+        return parseFunctionDefinitions();
     }
-}
-void Parser::parseFunctionDefinitions() {
-    prod(Rule::FuncDefs, "<Function Definitions> -> <Function> <Function Definitions Prime>");
-    parseFunction();
-    parseFunctionDefinitionsPrime();
-}
-void Parser::parseFunctionDefinitionsPrime() {
-    skipBannerStrings();  // <== NEW (handles banners *between* functions)
-    if (isKw("function")) {
-        prod(Rule::FuncDefsPrime, "<Function Definitions Prime> -> <Function> <Function Definitions Prime>");
-        parseFunction();
-        parseFunctionDefinitionsPrime();
-    } else {
-        prod(Rule::FuncDefsPrime, "<Function Definitions Prime> -> ε");
+    prod(Prod::OptFuncDefsEps);
+    return 0;
+}
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseFunctionDefinitions() {
+    PROFILE_RULE(FuncDefs);
+    prod(Prod::FuncDefs);
+    NodeList fns;
+    append(fns, parseFunction());
+    parseFunctionDefinitionsPrime(fns);
+    return fns.head;
+}
+// Prime productions are tail-recursive; they run as loops so long lists don't
+// cost a stack frame per element. The trace is the same as the recursive form.
+template <class TracePolicy>
+void Parser<TracePolicy>::parseFunctionDefinitionsPrime(NodeList& fns) {
+    PROFILE_RULE(FuncDefsPrime);
+    for (;;) {
+        skipBannerStrings();  // <== NEW (handles banners *between* functions)
+        if (!isKw(TokId::Function)) break;
+        prod(Prod::FuncDefsPrime);
+        append(fns, parseFunction());
     }
-}
-void Parser::parseFunction() {
-    prod(Rule::Function, "<Function> -> function <Identifier> ( <Opt Parameter List> ) <Opt Declaration List> <Body>");
-    expectKw("function");
-    expectIdentifier();
-    expectSep("(");
-    parseOptParameterList();
-    expectSep(")");
-    parseOptDeclarationList();
-    parseBody();
-}
-void Parser::parseOptParameterList() {
+    prod(Prod::FuncDefsPrimeEps);
+}
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseFunction() {
+    PROFILE_RULE(Function);
+    NodeId fn = recoverable(Sync::Function, [&] { return parseFunctionAlt(); });
+    if (checking_) symbols_.leaveFunction();   // also after a recovered error
+    return fn;
+}
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseFunctionAlt() {
+    NodeId fn = node(NodeKind::Function);
+    prod(Prod::Function);
+    expectKw(TokId::Function);
+    const TokenPos pos = checking_ ? here() : TokenPos{};
+    std::uint32_t name = expectIdentifier();
+    if (checking_) symbols_.enterFunction();
+    expectSep(TokId::LParen);
+    NodeId params = parseOptParameterList();
+    expectSep(TokId::RParen);
+    // declared before the body, so recursive calls resolve
+    if (checking_ && !symbols_.declareFunction(name, static_cast<std::uint32_t>(symbols_.mark()), pos.line, pos.col))
+        semanticError(DiagCode::DuplicateFunction, name, pos.line, pos.col);
+    NodeId decls = parseOptDeclarationList();
+    NodeId body = parseBody();
+    if (fn) { AstNode& n = at(fn); n.a = name; n.b = params; n.c = decls; n.d = body; }
+    return fn;
+}
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseOptParameterList() {
+    PROFILE_RULE(OptParamList);
     // parameters start with an identifier, not the qualifier
     if (tok_.type == TokenType::Identifier) {
-        prod(Rule::OptParamList, "<Opt Parameter List> -> <Parameter List>");
-        parseParameterList();
-    } else {
-        prod(Rule::OptParamList, "<Opt Parameter List> -> ε");
+        prod(Prod::OptParamList);
+        return parseParameterList();
     }
-}
-void Parser::parseParameterList() {
-    prod(Rule::ParamList, "<Parameter List> -> <Parameter> <Parameter List Prime>");
-    parseParameter();
-    parseParameterListPrime();
-}
-void Parser::parseParameterListPrime() {
-    if (isSep(",")) {
-        prod(Rule::ParamListPrime, "<Parameter List Prime> -> , <Parameter> <Parameter List Prime>");
-        expectSep(",");
-        parseParameter();
-        parseParameterListPrime();
-    } else {
-        prod(Rule::ParamListPrime, "<Parameter List Prime> -> ε");
+    prod(Prod::OptParamListEps);
+    return 0;
+}
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseParameterList() {
+    PROFILE_RULE(ParamList);
+    prod(Prod::ParamList);
+    NodeList params;
+    append(params, parseParameter());
+    parseParameterListPrime(params);
+    return params.head;
+}
+template <class TracePolicy>
+void Parser<TracePolicy>::parseParameterListPrime(NodeList& params) {
+    PROFILE_RULE(ParamListPrime);
+    while (isSep(TokId::Comma)) {
+        prod(Prod::ParamListPrime);
+        expectSep(TokId::Comma);
+        append(params, parseParameter());
     }
+    prod(Prod::ParamListPrimeEps);
 }
-void Parser::parseParameter() {
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseParameter() {
+    PROFILE_RULE(Parameter);
     // <Parameter> -> <IDs> <Qualifier>
-    prod(Rule::Parameter, "<Parameter> -> <IDs> <Qualifier>");
-    parseIDs();
-    parseQualifier();
-}
-void Parser::parseQualifier() {
-    if (isKw("integer") || isKw("boolean") || isKw("real")) {
-        prod(Rule::Qualifier, "<Qualifier> -> integer | boolean | real");
-        echoToken(); advance();
-    } else {
-        errorHere("qualifier (integer|boolean|real) expected");
-    }
+    prod(Prod::Parameter);
+    const size_t mark = symbols_.mark();
+    NodeId ids = parseIDs(IdRole::Declare);
+    TokId q = parseQualifier();
+    if (checking_) symbols_.setTypesSince(mark, q);
+    retag(ids, NodeKind::Param, q);
+    return ids;
+}
+template <class TracePolicy>
+TokId Parser<TracePolicy>::parseQualifier() {
+    PROFILE_RULE(Qualifier);
+    if (!isKwIn(kQualifier)) errorHere(DiagCode::ExpectedQualifier);
+    prod(Prod::Qualifier);
+    TokId q = tok_.id;
+    echoToken(); advance();
+    return q;
 }
 
-void Parser::parseBody() {
-    prod(Rule::Body, "<Body> -> { <Opt Statement List> }");
-    expectSep("{");
-    parseOptStatementList(); // instead of parseStatementList()
-    expectSep("}");
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseBody() {
+    PROFILE_RULE(Body);
+    prod(Prod::Body);
+    expectSep(TokId::LBrace);
+    NodeId stmts = parseOptStatementList(); // instead of parseStatementList()
+    expectSep(TokId::RBrace);
+    return stmts;
 }
 
 // ----- Declarations -----
-void Parser::parseOptDeclarationList() {
-    if (isKw("integer") || isKw("boolean") || isKw("real")) {
-        prod(Rule::OptDeclList, "<Opt Declaration List> -> <Declaration List>");
-        parseDeclarationList();
-    } else {
-        prod(Rule::OptDeclList, "<Opt Declaration List> -> ε");
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseOptDeclarationList() {
+    PROFILE_RULE(OptDeclList);
+    if (isKwIn(kQualifier)) {
+        prod(Prod::OptDeclList);
+        return parseDeclarationList();
     }
-}
-void Parser::parseDeclarationList() {
-    prod(Rule::DeclList, "<Declaration List> -> <Declaration> ; <Declaration List Prime>");
-    parseDeclaration();
-    expectSep(";");
-    parseDeclarationListPrime();
-}
-void Parser::parseDeclarationListPrime() {
-    if (isKw("integer") || isKw("boolean") || isKw("real")) {
-        prod(Rule::DeclListPrime, "<Declaration List Prime> -> <Declaration> ; <Declaration List Prime>");
-        parseDeclaration();
-        expectSep(";");
-        parseDeclarationListPrime();
-    } else {
-        prod(Rule::DeclListPrime, "<Declaration List Prime> -> ε");
+    prod(Prod::OptDeclListEps);
+    return 0;
+}
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseDeclarationList() {
+    PROFILE_RULE(DeclList);
+    prod(Prod::DeclList);
+    NodeList decls;
+    append(decls, parseDeclarationItem());
+    parseDeclarationListPrime(decls);
+    return decls.head;
+}
+template <class TracePolicy>
+void Parser<TracePolicy>::parseDeclarationListPrime(NodeList& decls) {
+    PROFILE_RULE(DeclListPrime);
+    while (isKwIn(kQualifier)) {
+        prod(Prod::DeclListPrime);
+        append(decls, parseDeclarationItem());
     }
-}
-void Parser::parseDeclaration() {
-    prod(Rule::Declaration, "<Declaration> -> <Qualifier> <IDs>");
-    parseQualifier();
-    parseIDs();
-}
-void Parser::parseIDs() {
-    prod(Rule::IDs, "<IDs> -> <Identifier> <IDs Prime>");
-    expectIdentifier();
-    parseIDsPrime();
-}
-void Parser::parseIDsPrime() {
-    if (isSep(",")) {
-        prod(Rule::IDsPrime, "<IDs Prime> -> , <IDs>");
-        expectSep(",");
-        parseIDs();
-    } else {
-        prod(Rule::IDsPrime, "<IDs Prime> -> ε");
+    prod(Prod::DeclListPrimeEps);
+}
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseDeclarationItem() {
+    return recoverable(Sync::Declaration, [&] {
+        NodeId d = parseDeclaration();
+        expectSep(TokId::Semicolon);
+        return d;
+    });
+}
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseDeclaration() {
+    PROFILE_RULE(Declaration);
+    prod(Prod::Declaration);
+    TokId q = parseQualifier();
+    const size_t mark = symbols_.mark();
+    NodeId ids = parseIDs(IdRole::Declare);
+    if (checking_) symbols_.setTypesSince(mark, q);
+    retag(ids, NodeKind::Decl, q);
+    return ids;
+}
+// Ident list; Declaration/Parameter retag the nodes in place
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseIDs(IdRole role, std::uint32_t* count) {
+    PROFILE_RULE(IDs);
+    prod(Prod::IDs);
+    NodeList ids;
+    append(ids, identNode(role));
+    if (count) *count = 1;
+    parseIDsPrime(ids, role, count);
+    return ids.head;
+}
+// <IDs Prime> -> , <IDs> recurses through parseIDs; unrolled here
+template <class TracePolicy>
+void Parser<TracePolicy>::parseIDsPrime(NodeList& ids, IdRole role, std::uint32_t* count) {
+    PROFILE_RULE(IDsPrime);
+    while (isSep(TokId::Comma)) {
+        prod(Prod::IDsPrime);
+        expectSep(TokId::Comma);
+        prod(Prod::IDs);
+        append(ids, identNode(role));
+        if (count) ++*count;
     }
+    prod(Prod::IDsPrimeEps);
 }
 
 // ----- Statements -----
-void Parser::parseStatementList() {
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseStatementList() {
+    PROFILE_RULE(StatementList);
     // Skip any stray banner strings before deciding if there are statements
     skipBannerStrings();                 // <<== NEW
 
     // Make Statement List *effectively optional* when there's nothing to parse.
-    if (tok_.type == TokenType::EndOfFile || isSep("}")) {
-        prod(Rule::StatementList, "<Statement List> -> ε"); // <<== NEW production line
-        return;
+    if (tok_.type == TokenType::EndOfFile || isSep(TokId::RBrace)) {
+        prod(Prod::StatementListEps); // <<== NEW production line
+        return 0;
     }
 
     // If a statement *can* start, parse it; otherwise epsilon.
-    if (isSep("{") || tok_.type == TokenType::Identifier || isKw("if") || isKw("return")
-        || isKw("put") || isKw("get") || isKw("while") ) {
-        prod(Rule::StatementList, "<Statement List> -> <Statement> <Statement List Prime>");
-        parseStatement();
-        parseStatementListPrime();
+    if (tok_.type == TokenType::Identifier || startsStatement()) {
+        prod(Prod::StatementList);
+        NodeList stmts;
+        append(stmts, parseStatement());
+        parseStatementListPrime(stmts);
+        return stmts.head;
         } else {
-            prod(Rule::StatementList, "<Statement List> -> ε"); // <<== NEW safe fallback
+            prod(Prod::StatementListEps); // <<== NEW safe fallback
         }
+    return 0;
 }
 
-void Parser::parseStatementListPrime() {
-    skipBannerStrings();                 // <<== NEW
+template <class TracePolicy>
+void Parser<TracePolicy>::parseStatementListPrime(NodeList& stmts) {
+    PROFILE_RULE(StatementListPrime);
+    for (;;) {
+        skipBannerStrings();             // <<== NEW
 
-    if (tok_.type == TokenType::EndOfFile || isSep("}")) {
-        prod(Rule::StatementListPrime, "<Statement List Prime> -> ε");
-        return;
+        if (tok_.type == TokenType::EndOfFile || isSep(TokId::RBrace)) break;
+        if (tok_.type != TokenType::Identifier && !startsStatement()) break;
+        prod(Prod::StmtListPrime);
+        append(stmts, parseStatement());
     }
-    if (isSep("{") || tok_.type == TokenType::Identifier || isKw("if") || isKw("return")
-        || isKw("put") || isKw("get") || isKw("while")) {
-        prod(Rule::StatementListPrime, "<Statement List Prime> -> <Statement> <Statement List Prime>");
-        parseStatement();
-        parseStatementListPrime();
-        } else {
-            prod(Rule::StatementListPrime, "<Statement List Prime> -> ε");
-        }
+    prod(Prod::StmtListPrimeEps);
 }
 
-void Parser::parseOptStatementList() {
-    if (tok_.type == TokenType::EndOfFile || isSep("}")) {
-        prod(Rule::StatementList, "<Statement List> -> ε");
-        return;
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseOptStatementList() {
+    if (tok_.type == TokenType::EndOfFile || isSep(TokId::RBrace)) {
+        prod(Prod::StatementListEps);
+        return 0;
     }
-    parseStatementList();
+    return parseStatementList();
 }
 
 
-void Parser::parseStatement() {
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseStatement() {
+    PROFILE_RULE(Statement);
+    NestingScope nest(*this);
+    return recoverable(isKw(TokId::If) ? Sync::IfStatement : Sync::Statement,
+                       [&] { return parseStatementAlt(); });
+}
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseStatementAlt() {
 
     // Consume banner strings that appear as standalone "statements"
     if (tok_.type == TokenType::String) { // banner/comment line
         advance();                         // no echo
         // After consuming, let the caller continue its loop.
         // We return to let StatementList/Prime handle sequencing.
-        prod(Rule::Statement, "<Statement> -> ε"); // optional: mark we consumed nothing
-        return;
+        prod(Prod::StmtEps); // optional: mark we consumed nothing
+        return 0;          // no node either
     }
 
     // 선택된 대안만 출력 (메뉴판 제거)
-    if (isSep("{")) {
-        prod(Rule::Statement, "<Statement> -> <Compound>");
-        parseCompound();
+    if (isSep(TokId::LBrace)) {
+        prod(Prod::StmtCompound);
+        return parseCompound();
     } else if (tok_.type == TokenType::Identifier) {
-        prod(Rule::Statement, "<Statement> -> <Assign>");
-        parseAssign();
-    } else if (isKw("if")) {
-        prod(Rule::Statement, "<Statement> -> <If>");
-        parseIf();
-    } else if (isKw("return")) {
-        prod(Rule::Statement, "<Statement> -> <Return>");
-        parseReturn();
-    } else if (isKw("put")) {
-        prod(Rule::Statement, "<Statement> -> <Print>");
-        parsePrint();
-    } else if (isKw("get")) {
-        prod(Rule::Statement, "<Statement> -> <Scan>");
-        parseScan();
-    } else if (isKw("while")) {
-        prod(Rule::Statement, "<Statement> -> <While>");
-        parseWhile();
-    } else {
-        errorHere("statement expected");
-    }
-}
-void Parser::parseCompound() {
-    prod(Rule::Compound, "<Compound> -> { <Statement List> }");
-    expectSep("{");
-    parseStatementList();
-    expectSep("}");
-}
-void Parser::parseAssign() {
-    prod(Rule::Assign, "<Assign> -> <Identifier> = <Expression> ;");
-    expectIdentifier();
-    expectOp("=");
-    parseExpression();
-    expectSep(";");
-}
-void Parser::parseIf() {
-    prod(Rule::If, "<If> -> if ( <Condition> ) <Statement> <OptElse> fi");
-    expectKw("if");
-    expectSep("(");
-    parseCondition();
-    expectSep(")");
-    parseStatement();
-    parseOptElse();
-    expectKw("fi");
-}
-void Parser::parseOptElse() {
-    if (isKw("else")) {
-        prod(Rule::OptElse, "<OptElse> -> else <Statement>");
-        expectKw("else");
-        parseStatement();
-    } else {
-        prod(Rule::OptElse, "<OptElse> -> ε");
+        prod(Prod::StmtAssign);
+        return parseAssign();
+    } else if (isKw(TokId::If)) {
+        prod(Prod::StmtIf);
+        return parseIf();
+    } else if (isKw(TokId::Return)) {
+        prod(Prod::StmtReturn);
+        return parseReturn();
+    } else if (isKw(TokId::Put)) {
+        prod(Prod::StmtPrint);
+        return parsePrint();
+    } else if (isKw(TokId::Get)) {
+        prod(Prod::StmtScan);
+        return parseScan();
+    } else if (isKw(TokId::While)) {
+        prod(Prod::StmtWhile);
+        return parseWhile();
     }
-}
-void Parser::parseReturn() {
-    prod(Rule::Return, "<Return> -> return ; | return <Expression> ;");
-    expectKw("return");
-    if (isSep(";")) {
-        expectSep(";");
+    errorHere(DiagCode::ExpectedStatement);
+}
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseCompound() {
+    PROFILE_RULE(Compound);
+    NodeId c = node(NodeKind::Compound);
+    prod(Prod::Compound);
+    expectSep(TokId::LBrace);
+    NodeId stmts = parseStatementList();
+    expectSep(TokId::RBrace);
+    if (c) at(c).a = stmts;
+    return c;
+}
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseAssign() {
+    PROFILE_RULE(Assign);
+    NodeId s = node(NodeKind::Assign);
+    prod(Prod::Assign);
+    const TokenPos pos = checking_ ? here() : TokenPos{};
+    std::uint32_t target = expectIdentifier();
+    if (checking_) useVar(target, pos.line, pos.col);
+    expectOp(TokId::Assign);
+    NodeId e = parseExpression();
+    expectSep(TokId::Semicolon);
+    if (s) { AstNode& n = at(s); n.a = target; n.b = e; }
+    return s;
+}
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseIf() {
+    PROFILE_RULE(If);
+    NodeId s = node(NodeKind::If);
+    prod(Prod::If);
+    expectKw(TokId::If);
+    expectSep(TokId::LParen);
+    NodeId cond = parseCondition();
+    expectSep(TokId::RParen);
+    NodeId then = parseStatement();
+    NodeId els = parseOptElse();
+    expectKw(TokId::Fi);
+    if (s) { AstNode& n = at(s); n.a = cond; n.b = then; n.c = els; }
+    return s;
+}
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseOptElse() {
+    PROFILE_RULE(OptElse);
+    if (isKw(TokId::Else)) {
+        prod(Prod::OptElse);
+        expectKw(TokId::Else);
+        return parseStatement();
+    }
+    prod(Prod::OptElseEps);
+    return 0;
+}
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseReturn() {
+    PROFILE_RULE(Return);
+    NodeId s = node(NodeKind::Return);
+    prod(Prod::Return);
+    expectKw(TokId::Return);
+    NodeId e = 0;
+    if (isSep(TokId::Semicolon)) {
+        expectSep(TokId::Semicolon);
     } else {
-        parseExpression();
-        expectSep(";");
-    }
-}
-void Parser::parsePrint() {
-    prod(Rule::Print, "<Print> -> put ( <Expression> ) ;");
-    expectKw("put");
-    expectSep("(");
-    parseExpression();
-    expectSep(")");
-    expectSep(";");
-}
-void Parser::parseScan() {
-    prod(Rule::Scan, "<Scan> -> get ( <IDs> ) ;");
-    expectKw("get");
-    expectSep("(");
-    parseIDs();
-    expectSep(")");
-    expectSep(";");
-}
-void Parser::parseWhile() {
-    prod(Rule::While, "<While> -> while ( <Condition> ) <Statement>");
-    expectKw("while");
-    expectSep("(");
-    parseCondition();
-    expectSep(")");
-    parseStatement();
+        e = parseExpression();
+        expectSep(TokId::Semicolon);
+    }
+    if (s) at(s).a = e;
+    return s;
+}
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parsePrint() {
+    PROFILE_RULE(Print);
+    NodeId s = node(NodeKind::Print);
+    prod(Prod::Print);
+    expectKw(TokId::Put);
+    expectSep(TokId::LParen);
+    NodeId e = parseExpression();
+    expectSep(TokId::RParen);
+    expectSep(TokId::Semicolon);
+    if (s) at(s).a = e;
+    return s;
+}
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseScan() {
+    PROFILE_RULE(Scan);
+    NodeId s = node(NodeKind::Scan);
+    prod(Prod::Scan);
+    expectKw(TokId::Get);
+    expectSep(TokId::LParen);
+    NodeId ids = parseIDs(IdRole::Use);
+    expectSep(TokId::RParen);
+    expectSep(TokId::Semicolon);
+    if (s) at(s).a = ids;
+    return s;
+}
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseWhile() {
+    PROFILE_RULE(While);
+    NodeId s = node(NodeKind::While);
+    prod(Prod::While);
+    expectKw(TokId::While);
+    expectSep(TokId::LParen);
+    NodeId cond = parseCondition();
+    expectSep(TokId::RParen);
+    NodeId body = parseStatement();
+    if (s) { AstNode& n = at(s); n.a = cond; n.b = body; }
+    return s;
 }
 
 // ----- Expressions -----
-void Parser::parseCondition() {
-    prod(Rule::Condition, "<Condition> -> <Expression> <Relop> <Expression>");
-    parseExpression();
-    parseRelop();
-    parseExpression();
-}
-
-void Parser::parseRelop() {
-    if (isOp("==") || isOp("!=") || isOp(">") || isOp("<") || isOp("<=") || isOp(">=")) {
-        if (trace_.master && trace_.enabled.count(Rule::Relop)) {
-            sink_->emit(std::string("<Relop> -> ") + tok_.lexeme);
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseCondition() {
+    PROFILE_RULE(Condition);
+    NodeId c = node(NodeKind::Relational);
+    prod(Prod::Condition);
+    NodeId lhs = parseExpression();
+    TokId op = parseRelop();
+    NodeId rhs = parseExpression();
+    if (c) { AstNode& n = at(c); n.op = op; n.a = lhs; n.b = rhs; }
+    return c;
+}
+
+template <class TracePolicy>
+TokId Parser<TracePolicy>::parseRelop() {
+    PROFILE_RULE(Relop);
+    if (tok_.type != TokenType::Operator || !inSet(kRelop)) errorHere(DiagCode::ExpectedRelop);
+    if constexpr (TracePolicy::kTrace) {
+        if (filter_.relop) sink_->relop(tok_);
+    }
+    TokId op = tok_.id;
+    echoToken();
+    advance();
+    return op;
+}
+
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseExpression() {
+    PROFILE_RULE(Expression);
+    prod(Prod::Expression);
+    NodeId lhs = parseTerm();
+    return parseExpressionPrime(lhs);
+}
+// folds the loop into left-associative Binary nodes
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseExpressionPrime(NodeId lhs) {
+    PROFILE_RULE(ExpressionPrime);
+    for (;;) {
+        TokId op;
+        if (isOp(TokId::Plus)) {
+            prod(Prod::ExprPrimePlus);
+            op = TokId::Plus;
+        } else if (isOp(TokId::Minus)) {
+            prod(Prod::ExprPrimeMinus);
+            op = TokId::Minus;
+        } else {
+            break;
         }
-        echoToken();
-        advance();
-    } else {
-        errorHere("relational operator expected");
-    }
-}
-
-void Parser::parseExpression() {
-    prod(Rule::Expression, "<Expression> -> <Term> <Expression Prime>");
-    parseTerm();
-    parseExpressionPrime();
-}
-void Parser::parseExpressionPrime() {
-    if (isOp("+")) {
-        prod(Rule::ExpressionPrime, "<Expression Prime> -> + <Term> <Expression Prime>");
-        expectOp("+");
-        parseTerm();
-        parseExpressionPrime();
-    } else if (isOp("-")) {
-        prod(Rule::ExpressionPrime, "<Expression Prime> -> - <Term> <Expression Prime>");
-        expectOp("-");
-        parseTerm();
-        parseExpressionPrime();
-    } else {
-        prod(Rule::ExpressionPrime, "<Expression Prime> -> ε");
-    }
-}
-void Parser::parseTerm() {
-    prod(Rule::Term, "<Term> -> <Factor> <Term Prime>");
-    parseFactor();
-    parseTermPrime();
-}
-void Parser::parseTermPrime() {
-    if (isOp("*")) {
-        prod(Rule::TermPrime, "<Term Prime> -> * <Factor> <Term Prime>");
-        expectOp("*");
-        parseFactor();
-        parseTermPrime();
-    } else if (isOp("/")) {
-        prod(Rule::TermPrime, "<Term Prime> -> / <Factor> <Term Prime>");
-        expectOp("/");
-        parseFactor();
-        parseTermPrime();
-    } else {
-        prod(Rule::TermPrime, "<Term Prime> -> ε");
+        NodeId bin = node(NodeKind::Binary);
+        expectOp(op);
+        NodeId rhs = parseTerm();
+        if (bin) { AstNode& n = at(bin); n.op = op; n.a = lhs; n.b = rhs; }
+        lhs = bin;
     }
-}
-void Parser::parseFactor() {
-    if (isOp("-")) {
-        prod(Rule::Factor, "<Factor> -> - <Primary>");
-        expectOp("-");
-        parsePrimary();
-    } else {
-        prod(Rule::Factor, "<Factor> -> <Primary>");
-        parsePrimary();
+    prod(Prod::ExprPrimeEps);
+    return lhs;
+}
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseTerm() {
+    PROFILE_RULE(Term);
+    prod(Prod::Term);
+    NodeId lhs = parseFactor();
+    return parseTermPrime(lhs);
+}
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseTermPrime(NodeId lhs) {
+    PROFILE_RULE(TermPrime);
+    for (;;) {
+        TokId op;
+        if (isOp(TokId::Star)) {
+            prod(Prod::TermPrimeStar);
+            op = TokId::Star;
+        } else if (isOp(TokId::Slash)) {
+            prod(Prod::TermPrimeSlash);
+            op = TokId::Slash;
+        } else {
+            break;
+        }
+        NodeId bin = node(NodeKind::Binary);
+        expectOp(op);
+        NodeId rhs = parseFactor();
+        if (bin) { AstNode& n = at(bin); n.op = op; n.a = lhs; n.b = rhs; }
+        lhs = bin;
     }
+    prod(Prod::TermPrimeEps);
+    return lhs;
+}
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parseFactor() {
+    PROFILE_RULE(Factor);
+    if (isOp(TokId::Minus)) {
+        NodeId neg = node(NodeKind::Neg);
+        prod(Prod::FactorNeg);
+        expectOp(TokId::Minus);
+        NodeId e = parsePrimary();
+        if (neg) at(neg).a = e;
+        return neg;
+    }
+    prod(Prod::Factor);
+    return parsePrimary();
 }
-void Parser::parsePrimary() {
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parsePrimary() {
+    PROFILE_RULE(Primary);
     if (tok_.type == TokenType::Identifier) {
-        prod(Rule::Primary, "<Primary> -> <Identifier> <Primary Prime>");
-        expectIdentifier();
-        parsePrimaryPrime();
+        NodeId id = node(NodeKind::Ident);
+        prod(Prod::PrimaryId);
+        const TokenPos pos = checking_ ? here() : TokenPos{};
+        const TokId soft = tok_.id;   // true / false are lexed as identifiers
+        std::uint32_t name = expectIdentifier();
+        const bool call = isSep(TokId::LParen);
+        const bool boolLit = !call && (soft == TokId::True || soft == TokId::False);
+        std::uint32_t argc = 0;
+        NodeId args = parsePrimaryPrime(argc);
+        if (checking_ && !boolLit) {
+            if (call) useFunction(name, argc, pos.line, pos.col);
+            else      useVar(name, pos.line, pos.col);
+        }
+        if (id) {
+            AstNode& n = at(id);
+            n.a = name;
+            if (args) { n.kind = NodeKind::Call; n.b = args; }
+            // the trace keeps <Primary> -> <Identifier>; the tree has the literal
+            if (boolLit) { n.kind = NodeKind::BoolLit; n.op = soft; }
+        }
+        return id;
     } else if (tok_.type == TokenType::Integer) {
-        prod(Rule::Primary, "<Primary> -> <Integer>");
-        echoToken(); advance();
+        prod(Prod::PrimaryInt);
+        return literal(NodeKind::IntLit);
     } else if (tok_.type == TokenType::Real) {
-        prod(Rule::Primary, "<Primary> -> <Real>");
-        echoToken(); advance();
-    } else if (isSep("(")) {
-        prod(Rule::Primary, "<Primary> -> ( <Expression> )");
-        expectSep("(");
-        parseExpression();
-        expectSep(")");
-    } else if ((tok_.lexeme == "true" || tok_.lexeme == "false")
+        prod(Prod::PrimaryReal);
+        return literal(NodeKind::RealLit);
+    } else if (isSep(TokId::LParen)) {
+        NestingScope nest(*this);
+        prod(Prod::PrimaryParen);
+        expectSep(TokId::LParen);
+        NodeId e = parseExpression();   // no node for the parentheses
+        expectSep(TokId::RParen);
+        return e;
+    } else if ((tok_.id == TokId::True || tok_.id == TokId::False)
                && (tok_.type == TokenType::Identifier || tok_.type == TokenType::Keyword)) {
-        prod(Rule::Primary, "<Primary> -> true | false");
-        echoToken(); advance();
+        prod(Prod::PrimaryBool);
+        return literal(NodeKind::BoolLit);
     } else if (policy_.allowStringPrimary && tok_.type == TokenType::String) {
-        prod(Rule::Primary, "<Primary> -> <String>");
-        echoToken(); advance();
-    } else {
-        errorHere("primary expected");
+        prod(Prod::PrimaryString);
+        return literal(NodeKind::StringLit);
     }
-}
-void Parser::parsePrimaryPrime() {
-    if (isSep("(")) {
-        prod(Rule::PrimaryPrime, "<Primary Prime> -> ( <IDs> )");
-        expectSep("(");
-        parseIDs();
-        expectSep(")");
-    } else {
-        prod(Rule::PrimaryPrime, "<Primary Prime> -> ε");
+    errorHere(DiagCode::ExpectedPrimary);
+}
+// argument list head for a call, 0 otherwise
+template <class TracePolicy>
+NodeId Parser<TracePolicy>::parsePrimaryPrime(std::uint32_t& argc) {
+    PROFILE_RULE(PrimaryPrime);
+    if (isSep(TokId::LParen)) {
+        prod(Prod::PrimaryPrimeCall);
+        expectSep(TokId::LParen);
+        NodeId args = parseIDs(IdRole::Use, &argc);
+        expectSep(TokId::RParen);
+        return args;
     }
+    prod(Prod::PrimaryPrimeEps);
+    return 0;
 }
 
 //Comment handling
-void Parser::skipDocStrings() {
+template <class TracePolicy>
+void Parser<TracePolicy>::skipDocStrings() {
     while (tok_.type == TokenType::String) {
         echoToken();
         advance();
@@ -516,9 +985,13 @@ void Parser::skipDocStrings() {
 }
 
 // Consume any top-level/bare string tokens (banner comments).
-void Parser::skipBannerStrings() {
+template <class TracePolicy>
+void Parser<TracePolicy>::skipBannerStrings() {
     while (tok_.type == TokenType::String) {
         // do NOT echo; banners should be invisible in output
         advance();
     }
 }
+
+template class Parser<FullTrace>;
+template class Parser<NoTrace>;
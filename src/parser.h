@@ -1,11 +1,21 @@
 // Parser.h
 #pragma once
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <string_view>
+#include <array>
 #include <unordered_set>
+#include <vector>
+#include "Ast.h"
+#include "Diagnostic.h"
+#include "Grammar.h"
 #include "Lexer.h"
+#include "Profile.h"
+#include "Sink.h"
+#include "SymbolTable.h"
 #include "Token.h"
+#include "TokenSource.h"
 
 enum class StartSymbol {
     Program,     // <Rat25F>
@@ -13,18 +23,6 @@ enum class StartSymbol {
     Expression   // <Expression>
 };
 
-enum class Rule {
-    // Top-level
-    Rat25F, OptFuncDefs, FuncDefs, FuncDefsPrime, Function,
-    OptParamList, ParamList, ParamListPrime, Parameter, Qualifier,
-    Body, OptDeclList, DeclList, DeclListPrime, Declaration, IDs, IDsPrime,
-    // Statements
-    StatementList, StatementListPrime, Statement, Compound, Assign, If, OptElse,
-    Return, Print, Scan, While,
-    // Expressions
-    Condition, Relop, Expression, ExpressionPrime, Term, TermPrime, Factor, Primary, PrimaryPrime
-};
-
 struct TraceConfig {
     bool master = true;          // Print on/off
     bool hideEpsilon = true;     // hide "ε"
@@ -37,107 +35,195 @@ struct TraceConfig {
     };
 };
 
+// TraceConfig flattened to one flag per production, built once by the Parser
+struct TraceFilter {
+    explicit TraceFilter(const TraceConfig& trace);
+    std::array<bool, kProdCount> show{};
+    bool relop = false;   // <Relop> -> op lines
+};
+
 struct ParserPolicy {
     bool echoTokens = true;         // print token eco
     bool lenientKeywords = true;    // allow identifier keyword
     bool allowStringPrimary = true; // Primary allow string
+    // max nesting of statements / parenthesized expressions (0 = unlimited);
+    // list productions are loops, so only real nesting uses stack
+    size_t maxNesting = 4096;
+    // StartSymbol::Program only: undeclared names, duplicate declarations
+    // and call arity, reported as "Semantic error: ..."
+    bool semanticChecks = false;
+    // panic-mode recovery: record each error in diagnostics(), resync and go on
+    bool recover = false;
+    size_t maxDiagnostics = 100;    // recorded at most; the rest are only counted
 };
 
-struct ProductionSink {
-    virtual ~ProductionSink() = default;
-    virtual void emit(std::string_view line) = 0;
+// Compile-time trace policies. FullTrace keeps the runtime TraceConfig /
+// echoTokens switches; NoTrace drops prod() and echoToken() entirely, for
+// yes/no validation runs.
+struct FullTrace {
+    static constexpr bool kTrace = true;
+    static constexpr bool kEcho = true;
 };
-
-struct ConsoleSink : ProductionSink {
-    void emit(std::string_view line) override;
+struct NoTrace {
+    static constexpr bool kTrace = false;
+    static constexpr bool kEcho = false;
 };
 
-// pretty print for token type
-const char* prettyTokenKind(TokenType t);
-
+template <class TracePolicy = FullTrace>
 class Parser {
 public:
-    Parser(Lexer& lex,
-           TraceConfig trace = {},
+    Parser(TokenSource& lex,
+           const TraceConfig& trace = {},
            ParserPolicy policy = {},
            std::shared_ptr<ProductionSink> sink = std::make_shared<ConsoleSink>());
 
+    // next input, same trace filter and sink; the diagnostics, interner and
+    // symbol table buffers keep their capacity (one warm Parser per worker)
+    void reset(TokenSource& lex);
+    void reset(TokenSource& lex, const ParserPolicy& policy);
+
     // select starting symbol
     void parse(StartSymbol start = StartSymbol::Program);
+    // same, also building the AST into `out` (cleared first); combine with
+    // Parser<NoTrace> for an AST-only run
+    void parse(StartSymbol start, ParseResult& out);
+
+    // errors of the last parse when policy.recover is set (in source order)
+    const DiagnosticList& diagnostics() const { return diags_; }
+    size_t droppedDiagnostics() const { return dropped_; }
+
+    // pieces of <Rat25F> for split parsing (SplitParse.h)
+    void parseFunctionUnit();   // <Function> + trailing banners, then end of input
+    void parseProgramTail();    // the rest of <Rat25F> after the last <Function>
 
 private:
-    void parseRat25F();
+    NodeId parseStart(StartSymbol start);
+    NodeId parseRat25F();
 
     // Function defs & declarations
-    void parseOptFunctionDefinitions();
-    void parseFunctionDefinitions();
-    void parseFunctionDefinitionsPrime();
-    void parseFunction();
-    void parseOptParameterList();
-    void parseParameterList();
-    void parseParameterListPrime();
-    void parseParameter();
-    void parseQualifier();
-    void parseBody();
-    void parseOptDeclarationList();
-    void parseDeclarationList();
-    void parseDeclarationListPrime();
-    void parseDeclaration();
-    void parseIDs();
-    void parseIDsPrime();
+    NodeId parseOptFunctionDefinitions();
+    NodeId parseFunctionDefinitions();
+    void parseFunctionDefinitionsPrime(NodeList& fns);
+    NodeId parseFunction();
+    NodeId parseFunctionAlt();
+    NodeId parseOptParameterList();
+    NodeId parseParameterList();
+    void parseParameterListPrime(NodeList& params);
+    NodeId parseParameter();
+    TokId parseQualifier();
+    NodeId parseBody();
+    NodeId parseOptDeclarationList();
+    NodeId parseDeclarationList();
+    void parseDeclarationListPrime(NodeList& decls);
+    NodeId parseDeclaration();
+    NodeId parseDeclarationItem();   // <Declaration> ;
+    enum class IdRole { Declare, Use };
+    NodeId parseIDs(IdRole role, std::uint32_t* count = nullptr);
+    void parseIDsPrime(NodeList& ids, IdRole role, std::uint32_t* count);
 
     // Statements
-    void parseStatementList();
-    void parseStatementListPrime();
-    void parseOptStatementList();
-    void parseStatement();
-    void parseCompound();
-    void parseAssign();
-    void parseIf();
-    void parseOptElse();
-    void parseReturn();
-    void parsePrint();
-    void parseScan();
-    void parseWhile();
+    NodeId parseStatementList();
+    void parseStatementListPrime(NodeList& stmts);
+    NodeId parseOptStatementList();
+    NodeId parseStatement();
+    NodeId parseStatementAlt();
+    NodeId parseCompound();
+    NodeId parseAssign();
+    NodeId parseIf();
+    NodeId parseOptElse();
+    NodeId parseReturn();
+    NodeId parsePrint();
+    NodeId parseScan();
+    NodeId parseWhile();
 
     // Expressions
-    void parseCondition();
-    void parseRelop();
-    void parseExpression();
-    void parseExpressionPrime();
-    void parseTerm();
-    void parseTermPrime();
-    void parseFactor();
-    void parsePrimary();
-    void parsePrimaryPrime();
+    NodeId parseCondition();
+    TokId parseRelop();
+    NodeId parseExpression();
+    NodeId parseExpressionPrime(NodeId lhs);
+    NodeId parseTerm();
+    NodeId parseTermPrime(NodeId lhs);
+    NodeId parseFactor();
+    NodeId parsePrimary();
+    NodeId parsePrimaryPrime(std::uint32_t& argc);
 
     // helpers
     void advance();
-    bool isKw(const char* s) const;
-    bool isOp(const char* s) const;
-    bool isSep(const char* s) const;
-
-    [[noreturn]] void errorHere(const std::string& msg) const;
+    bool isKw(TokId id) const;
+    bool isOp(TokId id) const;
+    bool isSep(TokId id) const;
+    bool inSet(std::uint64_t set) const;   // tok_.id in a tokSet() mask
+    bool isKwIn(std::uint64_t set) const;  // isKw() for any ID in the mask
+    bool startsStatement() const;          // FIRST(<Statement>) minus Identifier
+
+    TokenPos here() const { return lex_->position(tok_); }   // of tok_, computed on demand
+    [[noreturn]] void errorHere(DiagCode code, TokId expected = TokId::None, std::uint32_t count = 0) const;
     void echoToken();
 
     // production print
-    void prod(Rule r, const char* text);
+    void prod(Prod p);
+
+    // AST building (no-ops without ast_)
+    NodeId node(NodeKind kind);               // new node at tok_
+    AstNode& at(NodeId id) { return (*ast_)[id]; }
+    void append(NodeList& list, NodeId n);
+    void retag(NodeId ids, NodeKind kind, TokId qualifier);  // Ident list -> Param/Decl
+    NodeId identNode(IdRole role);            // Ident for the expected identifier
+    NodeId literal(NodeKind kind);            // leaf for the current token, consumed
+
+    // semantic checks (only when checking_)
+    void declareVar(std::uint32_t name, std::uint32_t line, std::uint32_t col);
+    void useVar(std::uint32_t name, std::uint32_t line, std::uint32_t col);
+    void useFunction(std::uint32_t name, std::uint32_t argc, std::uint32_t line, std::uint32_t col);
+    void resolvePending();
+    void semanticError(DiagCode code, std::uint32_t name, std::uint32_t line, std::uint32_t col,
+                       std::uint32_t count = 0, std::uint32_t got = 0);
+
+    // error recovery (policy_.recover)
+    enum class Sync { Statement, IfStatement, Declaration, Function };
+    template <class F> NodeId recoverable(Sync sync, F&& parseFn);
+    template <class F> auto settled(F&& parseFn);   // settle()s a ParseError that leaves
+    void report(const Diagnostic& d);
+    void synchronize(Sync sync);
 
     // expect
-    void expectIdentifier();
-    void expectKw(const char* s);
-    void expectOp(const char* s);
-    void expectSep(const char* s);
+    std::uint32_t expectIdentifier();         // interned name (0 without names_)
+    void expectKw(TokId id);
+    void expectOp(TokId id);
+    void expectSep(TokId id);
 
     //handling comments
     void skipDocStrings();
     void skipBannerStrings();
 
 
+    // counts statement / '(' nesting against policy_.maxNesting
+    struct NestingScope {
+        explicit NestingScope(Parser& p);
+        ~NestingScope() { --p_.depth_; }
+        NestingScope(const NestingScope&) = delete;
+        NestingScope& operator=(const NestingScope&) = delete;
+        Parser& p_;
+    };
+
 private:
-    Lexer& lex_;
+    TokenSource* lex_;
     Token tok_{};
-    TraceConfig trace_;
+    TraceFilter filter_;
     ParserPolicy policy_;
     std::shared_ptr<ProductionSink> sink_;
+    size_t depth_ = 0;
+    ParseResult* ast_ = nullptr;   // set only inside parse(start, out)
+    Interner ownNames_;            // names for checks-only runs
+    Interner* names_ = nullptr;    // ast_->names or ownNames_; null = don't intern
+    SymbolTable symbols_;
+    bool checking_ = false;
+    DiagnosticList diags_;   // reserved to maxDiagnostics when recovering; unformatted
+    size_t dropped_ = 0;
+#ifdef RAT25F_PROFILE
+    ThreadProfile* prof_ = &threadProfile();   // a Parser runs on the thread that built it
+#endif
 };
+
+extern template class Parser<FullTrace>;
+extern template class Parser<NoTrace>;
@@ -0,0 +1,31 @@
+// tracedump: a binary trace (BinaryTrace.h, written by `parser -b`) back to
+// the text the parser would have written, byte for byte.
+//
+//   tracedump <trace> <output> [<source>]
+//
+// <source> is the file that was parsed; traces of stdin carry their tokens
+// and need none. An output of "-" is stdout.
+#include <iostream>
+#include <memory>
+#include <string>
+#include "BinaryTrace.h"
+#include "MappedFile.h"
+
+int main(int argc, char** argv) {
+    if (argc < 3 || argc > 4) {
+        std::cerr << "Usage: " << argv[0] << " <trace> <output> [<source>]\n";
+        return 1;
+    }
+    const std::string tracePath = argv[1], outPath = argv[2];
+    MappedFile trace, source;
+    if (!trace.open(tracePath)) { std::cerr << "Error: cannot open trace: " << tracePath << "\n"; return 1; }
+    if (argc == 4 && !source.open(argv[3])) { std::cerr << "Error: cannot open source: " << argv[3] << "\n"; return 1; }
+
+    auto out = outPath == "-" ? std::make_unique<BufferedFileSink>(1) : std::make_unique<BufferedFileSink>(outPath);
+    if (!out->ok()) { std::cerr << "Error: cannot open output file: " << outPath << "\n"; return 1; }
+    std::string error;
+    const bool ok = decodeTrace(trace.view(), source.view(), *out, error);
+    out->flush();
+    if (!ok) { std::cerr << "Error: " << tracePath << ": " << error << "\n"; return 1; }
+    return 0;
+}